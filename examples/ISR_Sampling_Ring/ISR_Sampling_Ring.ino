@@ -0,0 +1,146 @@
+/****************************************************************************************************************************
+  ISR_Sampling_Ring.ino
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.2+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32, ESP32_S2, ESP32_S3, ESP32_C3 have two timer groups, TIMER_GROUP_0 and TIMER_GROUP_1
+  1) each group of ESP32, ESP32_S2, ESP32_S3 has two general purpose hardware timers, TIMER_0 and TIMER_1
+  2) each group of ESP32_C3 has ony one general purpose hardware timer, TIMER_0
+
+  All the timers are based on 64-bit counters (except 54-bit counter for ESP32_S3 counter) and 16 bit prescalers.
+  The timer counters can be configured to count up or down and support automatic reload and software reload.
+  They can also generate alarms when they reach a specific value, defined by the software.
+  The value of the counter can be read by the software program.
+
+  Now even you use all these new 16 ISR-based timers,with their maximum interval practically unlimited (limited only by
+  unsigned long miliseconds), you just consume only one ESP32-S2 timer and avoid conflicting with other cores' tasks.
+  The accuracy is nearly perfect compared to software timers. The most important feature is they're ISR-based timers
+  Therefore, their executions are not blocked by bad-behaving functions / tasks.
+  This important feature is absolutely necessary for mission-critical tasks.
+*****************************************************************************************************************************/
+/*
+   Notes:
+   Sharing multi-byte data between an ISR and loop() through volatile globals isn't safe: loop() can read a value half
+   written by the ISR, and the ISR can overwrite a value not read yet. Here, the timer ISR pushes each sample, with its
+   64-bit timestamp, into an ESP32SPSCRing, and loop() pops them in batches : no sample torn or lost while the ring
+   isn't full, and no critical section on either side.
+*/
+
+#if !defined( ESP32 )
+	#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+// These define's must be placed at the beginning before #include "ESP32TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+#define _TIMERINTERRUPT_LOGLEVEL_     0
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32TimerInterrupt.h"
+
+#define TIMER0_INTERVAL_US        1000
+
+typedef struct
+{
+	uint32_t  seq;
+	uint64_t  timestamp;        // in us
+} sample_t;
+
+// Up to 128ms of samples while loop() is busy
+ESP32SPSCRing<sample_t, 128> samples;
+
+// Init ESP32 timer 0
+ESP32Timer ITimer0(0);
+
+volatile uint32_t droppedSamples = 0;
+
+// With core v2.0.0+, you can't use Serial.print/println in ISR or crash.
+// and you can't use float calculation inside ISR
+bool IRAM_ATTR TimerHandler0(void * timerNo)
+{
+	static uint32_t seq = 0;
+
+	sample_t sample = { seq++, (uint64_t) esp_timer_get_time() };
+
+	// the only producer
+	if (!samples.push(sample))
+		droppedSamples++;
+
+	return true;
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ISR_Sampling_Ring on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	// Interval in microsecs
+	if (ITimer0.attachInterruptInterval(TIMER0_INTERVAL_US, TimerHandler0))
+	{
+		Serial.print(F("Starting  ITimer0 OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer0. Select another freq. or timer"));
+}
+
+#define BATCH_SIZE        16
+
+void loop()
+{
+	static uint32_t expectedSeq     = 0;
+	static uint32_t numSamples      = 0;
+	static uint32_t gaps            = 0;
+	static uint64_t lastTimestamp   = 0;
+	static uint64_t maxInterval     = 0;
+	static unsigned long lastPrint  = 0;
+
+	sample_t batch[BATCH_SIZE];
+	size_t   n;
+
+	// the only consumer
+	while ( (n = samples.pop(batch, BATCH_SIZE)) > 0)
+	{
+		for (size_t i = 0; i < n; i++)
+		{
+			if (batch[i].seq != expectedSeq)
+				gaps++;
+
+			if ( (numSamples > 0) && (batch[i].timestamp - lastTimestamp > maxInterval) )
+				maxInterval = batch[i].timestamp - lastTimestamp;
+
+			expectedSeq   = batch[i].seq + 1;
+			lastTimestamp = batch[i].timestamp;
+			numSamples++;
+		}
+	}
+
+	if (millis() - lastPrint >= 5000)
+	{
+		lastPrint = millis();
+
+		Serial.print(F("Samples = "));
+		Serial.print(numSamples);
+		Serial.print(F(", gaps = "));
+		Serial.print(gaps);
+		Serial.print(F(", dropped = "));
+		Serial.print(droppedSamples);
+		Serial.print(F(", max interval us = "));
+		Serial.println((uint32_t) maxInterval);
+	}
+
+	// Pretend to be busy, up to 100 samples waiting
+	delay(100);
+}
@@ -0,0 +1,138 @@
+/****************************************************************************************************************************
+  ISR_Static_Schedule.ino
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.2+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32, ESP32_S2, ESP32_S3, ESP32_C3 have two timer groups, TIMER_GROUP_0 and TIMER_GROUP_1
+  1) each group of ESP32, ESP32_S2, ESP32_S3 has two general purpose hardware timers, TIMER_0 and TIMER_1
+  2) each group of ESP32_C3 has ony one general purpose hardware timer, TIMER_0
+
+  All the timers are based on 64-bit counters (except 54-bit counter for ESP32_S3 counter) and 16 bit prescalers.
+  The timer counters can be configured to count up or down and support automatic reload and software reload.
+  They can also generate alarms when they reach a specific value, defined by the software.
+  The value of the counter can be read by the software program.
+
+  Now even you use all these new 16 ISR-based timers,with their maximum interval practically unlimited (limited only by
+  unsigned long miliseconds), you just consume only one ESP32-S2 timer and avoid conflicting with other cores' tasks.
+  The accuracy is nearly perfect compared to software timers. The most important feature is they're ISR-based timers
+  Therefore, their executions are not blocked by bad-behaving functions / tasks.
+  This important feature is absolutely necessary for mission-critical tasks.
+*****************************************************************************************************************************/
+
+/*
+   The 16 periodic jobs of ISR_16_Timers_Array, known at compile time, as an ESP32_ISR_StaticSchedule instead of
+   ESP32_ISR_Timer::setInterval() calls in setup(). The compiler generates Schedule.run(), calling each callback
+   directly when its countdown expires: no timer table to search, nothing registered at runtime, and only the
+   countdowns in RAM. The hardware timer interval is computed from the periods, 1s here.
+   The last job only runs 5 times.
+*/
+
+#if !defined( ESP32 )
+	#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+// These define's must be placed at the beginning before #include "ESP32TimerInterrupt.h"
+#define _TIMERINTERRUPT_LOGLEVEL_     1
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32TimerInterrupt.h"
+
+#define NUMBER_ISR_TIMERS         16
+
+volatile uint32_t callCount[NUMBER_ISR_TIMERS];
+
+// In ESP32, avoid doing something fancy in ISR, for example complex Serial.print with String() argument
+// With core v2.0.0+, you can't use Serial.print/println in ISR or crash.
+// and you can't use float calculation inside ISR
+template<uint8_t TIMER_NO>
+void IRAM_ATTR doingSomething()
+{
+	callCount[TIMER_NO]++;
+}
+
+// Periods in milliseconds, callbacks and optional number of runs, all fixed at compile time
+ESP32_ISR_StaticSchedule <
+	ESP32StaticTimer<1000L,  doingSomething<0>>,
+	ESP32StaticTimer<2000L,  doingSomething<1>>,
+	ESP32StaticTimer<3000L,  doingSomething<2>>,
+	ESP32StaticTimer<4000L,  doingSomething<3>>,
+	ESP32StaticTimer<5000L,  doingSomething<4>>,
+	ESP32StaticTimer<6000L,  doingSomething<5>>,
+	ESP32StaticTimer<7000L,  doingSomething<6>>,
+	ESP32StaticTimer<8000L,  doingSomething<7>>,
+	ESP32StaticTimer<9000L,  doingSomething<8>>,
+	ESP32StaticTimer<10000L, doingSomething<9>>,
+	ESP32StaticTimer<11000L, doingSomething<10>>,
+	ESP32StaticTimer<12000L, doingSomething<11>>,
+	ESP32StaticTimer<13000L, doingSomething<12>>,
+	ESP32StaticTimer<14000L, doingSomething<13>>,
+	ESP32StaticTimer<15000L, doingSomething<14>>,
+	ESP32StaticTimer<16000L, doingSomething<15>, 5>
+	> Schedule;
+
+// Init ESP32 timer 1
+ESP32Timer ITimer(1);
+
+bool IRAM_ATTR TimerHandler(void * timerNo)
+{
+	Schedule.run();
+
+	return true;
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ISR_Static_Schedule on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	Serial.print(F("Schedule tick ms = "));
+	Serial.println(Schedule.tickMs());
+
+	// Interval in microsecs
+	if (ITimer.attachInterruptInterval(Schedule.tickUs(), TimerHandler))
+	{
+		Serial.print(F("Starting  ITimer OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer. Select another freq. or timer"));
+}
+
+#define CHECK_INTERVAL_MS     20000L
+
+void loop()
+{
+	static uint32_t lastTime = 0;
+
+	uint32_t currTime = millis();
+
+	if (currTime - lastTime > CHECK_INTERVAL_MS)
+	{
+		Serial.print(F("Time = "));
+		Serial.print(currTime);
+		Serial.print(F(", calls ="));
+
+		for (uint8_t timerNo = 0; timerNo < NUMBER_ISR_TIMERS; timerNo++)
+		{
+			Serial.print(F(" "));
+			Serial.print(callCount[timerNo]);
+		}
+
+		Serial.println();
+
+		lastTime = currTime;
+	}
+}
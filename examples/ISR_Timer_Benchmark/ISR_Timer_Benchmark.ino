@@ -0,0 +1,329 @@
+/****************************************************************************************************************************
+  ISR_Timer_Benchmark.ino
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.2+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32, ESP32_S2, ESP32_S3, ESP32_C3 have two timer groups, TIMER_GROUP_0 and TIMER_GROUP_1
+  1) each group of ESP32, ESP32_S2, ESP32_S3 has two general purpose hardware timers, TIMER_0 and TIMER_1
+  2) each group of ESP32_C3 has ony one general purpose hardware timer, TIMER_0
+
+  All the timers are based on 64-bit counters (except 54-bit counter for ESP32_S3 counter) and 16 bit prescalers.
+  The timer counters can be configured to count up or down and support automatic reload and software reload.
+  They can also generate alarms when they reach a specific value, defined by the software.
+  The value of the counter can be read by the software program.
+
+  Now even you use all these new 16 ISR-based timers,with their maximum interval practically unlimited (limited only by
+  unsigned long miliseconds), you just consume only one ESP32-S2 timer and avoid conflicting with other cores' tasks.
+  The accuracy is nearly perfect compared to software timers. The most important feature is they're ISR-based timers
+  Therefore, their executions are not blocked by bad-behaving functions / tasks.
+  This important feature is absolutely necessary for mission-critical tasks.
+*****************************************************************************************************************************/
+
+/*
+   Benchmark of ISR_Timer.run() and of the timer setup paths, in CPU cycles read from the CCOUNT cycle counter
+   by ESP.getCycleCount(), and in ns.
+
+   run() is called once per 1ms tick, as from a 1kHz hardware timer, for every combination of
+   1) the number of active ISR-based timers
+   2) the percentage of one-shot timers. A fired one-shot timer is re-created after run(), outside the measurement
+   3) the timer period in ticks. Every timer is due once per period, i.e. 100% / period of the timers are due per tick
+
+   For each combination, the row gives the average and max cycles per tick, the average of the ticks where nothing
+   was due, and the cost of each fired callback above that idle cost (including it if no tick was idle).
+   Use these to select the hardware timer tick rate. The CPU load of the ISR is about
+   (cyc_idle_avg + due callbacks * cyc_per_cb) * tick rate / CPU clock
+
+   Results are printed as CSV, the header starting with "kind,". To keep the rows only :
+     grep -E "^(kind|run|setup)," log.txt > results.csv
+
+   It can also run on the host against the simulated ESP32, ESP.getCycleCount() then counting host time :
+     cp ISR_Timer_Benchmark.ino ISR_Timer_Benchmark.cpp
+     g++ -O2 -std=gnu++11 -DESP32 -DESP32_TIMER_INTERRUPT_HOST_SIM -DESP32_TIMER_INTERRUPT_HOST_SIM_MAIN=1 \
+         -I<path to ESP32TimerInterrupt>/src ISR_Timer_Benchmark.cpp -o ISR_Timer_Benchmark -lpthread
+*/
+
+#if !defined( ESP32 )
+	#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+// These define's must be placed at the beginning before #include "ESP32TimerInterrupt.h"
+// Don't use _TIMERINTERRUPT_LOGLEVEL_ > 0 here, or the logs will be measured
+#define _TIMERINTERRUPT_LOGLEVEL_     0
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32TimerInterrupt.h"
+
+// Number of measured run() ticks for each combination
+#define BENCH_TICKS                   1000
+
+// Number of measured calls for each setup path
+#define BENCH_SETUP_REPS              100
+
+#define BENCH_MAX_TIMERS              64
+
+const uint16_t numTimersList[]    = { 1, 4, 16, BENCH_MAX_TIMERS };
+const uint8_t  oneShotPctList[]   = { 0, 50, 100 };
+const uint16_t periodList[]       = { 1, 10, 100 };
+
+#define ARRAY_SIZE(a)                 (sizeof(a) / sizeof(a[0]))
+
+// Init ESP32 timer 0, only used to benchmark attachInterruptInterval()
+ESP32Timer ITimer(0);
+
+// Init ESP32_ISR_Timer with room for BENCH_MAX_TIMERS timers
+ESP32_ISR_TimerT<BENCH_MAX_TIMERS> ISR_Timer;
+
+volatile uint32_t firedCount = 0;
+
+uint32_t cpuFreqMHz;
+
+void IRAM_ATTR benchCallback()
+{
+	firedCount++;
+}
+
+bool IRAM_ATTR TimerHandler(void * timerNo)
+{
+	return true;
+}
+
+void printField(const char* value)
+{
+	Serial.print(value);
+	Serial.print(F(","));
+}
+
+void printField(const uint32_t& value)
+{
+	Serial.print(value);
+	Serial.print(F(","));
+}
+
+void printField(const float& value)
+{
+	Serial.print(value);
+	Serial.print(F(","));
+}
+
+void printHeader()
+{
+	Serial.println(F("kind,name,timers,oneshot_pct,period_ticks,samples,fired,due_pct,"
+	                 "cyc_avg,cyc_max,cyc_idle_avg,cyc_per_cb,ns_avg,ns_per_cb"));
+}
+
+float cyclesToNs(const float& cycles)
+{
+	return cycles * 1000.0f / cpuFreqMHz;
+}
+
+void benchRun(const uint16_t& numTimers, const uint8_t& oneShotPct, const uint16_t& period)
+{
+	uint16_t numOneShots  = (numTimers * oneShotPct) / 100;
+
+	ISR_Timer.init();
+
+	// Create the timers 1 tick apart, to spread their deadlines over the period
+	for (uint16_t i = 0; i < numTimers; i++)
+	{
+		if (i < numOneShots)
+			ISR_Timer.setTimeout(period, benchCallback);
+		else
+			ISR_Timer.setInterval(period, benchCallback);
+
+		delay(1);
+	}
+
+	uint32_t  samples     = 0;
+	uint32_t  fired       = 0;
+	uint64_t  cycles      = 0;
+	uint32_t  cyclesMax   = 0;
+	uint32_t  idleTicks   = 0;
+	uint64_t  idleCycles  = 0;
+
+	// The first period ticks are only warming up, catching up with the timers overdue after their creation
+	for (uint32_t tick = 0; tick < (uint32_t) period + BENCH_TICKS; tick++)
+	{
+		delay(1);
+
+		firedCount = 0;
+
+		uint32_t start = ESP.getCycleCount();
+
+		ISR_Timer.run();
+
+		uint32_t tickCycles = ESP.getCycleCount() - start;
+		uint32_t tickFired  = firedCount;
+
+		// Re-create the fired one-shot timers, to keep numTimers active timers
+		while (ISR_Timer.getNumTimers() < numTimers)
+			ISR_Timer.setTimeout(period, benchCallback);
+
+		if (tick < period)
+			continue;
+
+		samples++;
+		fired  += tickFired;
+		cycles += tickCycles;
+
+		if (tickCycles > cyclesMax)
+			cyclesMax = tickCycles;
+
+		if (tickFired == 0)
+		{
+			idleTicks++;
+			idleCycles += tickCycles;
+		}
+	}
+
+	float cyclesAvg     = (float) cycles / samples;
+	float cyclesIdleAvg = idleTicks ? (float) idleCycles / idleTicks : 0;
+	float cyclesPerCb   = fired ? ( (float) cycles - cyclesIdleAvg * samples) / fired : 0;
+
+	printField("run");
+	printField("run");
+	printField( (uint32_t) numTimers);
+	printField( (uint32_t) oneShotPct);
+	printField( (uint32_t) period);
+	printField(samples);
+	printField(fired);
+	printField(100.0f * fired / ( (float) samples * numTimers));
+	printField(cyclesAvg);
+	printField(cyclesMax);
+	printField(cyclesIdleAvg);
+	printField(cyclesPerCb);
+	printField(cyclesToNs(cyclesAvg));
+	Serial.println(cyclesToNs(cyclesPerCb));
+}
+
+void printSetupRow(const char* name, const uint16_t& numTimers, const uint64_t& cycles, const uint32_t& cyclesMax)
+{
+	float cyclesAvg = (float) cycles / BENCH_SETUP_REPS;
+
+	printField("setup");
+	printField(name);
+	printField( (uint32_t) numTimers);
+	Serial.print(F(",,"));
+	printField( (uint32_t) BENCH_SETUP_REPS);
+	Serial.print(F(",,"));
+	printField(cyclesAvg);
+	printField(cyclesMax);
+	Serial.print(F(",,"));
+	Serial.print(cyclesToNs(cyclesAvg));
+	Serial.println(F(","));
+}
+
+// attachInterruptInterval() = setFrequency() : timer_init() + alarm setup + timer_isr_callback_add()
+void benchSetupHardwareTimer()
+{
+	uint64_t cycles     = 0;
+	uint32_t cyclesMax  = 0;
+
+	for (uint16_t rep = 0; rep < BENCH_SETUP_REPS; rep++)
+	{
+		uint32_t start = ESP.getCycleCount();
+
+		ITimer.attachInterruptInterval(1000, TimerHandler);
+
+		uint32_t repCycles = ESP.getCycleCount() - start;
+
+		cycles += repCycles;
+
+		if (repCycles > cyclesMax)
+			cyclesMax = repCycles;
+
+		// Release the interrupt allocated by timer_isr_callback_add()
+		ITimer.stopTimer();
+		timer_isr_callback_remove( (timer_group_t) ITimer.getTimerGroup(), (timer_idx_t) ITimer.getTimer());
+	}
+
+	printSetupRow("attachInterruptInterval", 0, cycles, cyclesMax);
+}
+
+// setInterval(), changeInterval() and deleteTimer() of one more timer, with numTimers - 1 other active timers
+void benchSetupIsrTimer(const uint16_t& numTimers)
+{
+	uint64_t cycles[3]      = { 0, 0, 0 };
+	uint32_t cyclesMax[3]   = { 0, 0, 0 };
+	uint32_t start;
+	uint32_t repCycles[3];
+
+	ISR_Timer.init();
+
+	for (uint16_t i = 1; i < numTimers; i++)
+		ISR_Timer.setInterval(1000 + i, benchCallback);
+
+	for (uint16_t rep = 0; rep < BENCH_SETUP_REPS; rep++)
+	{
+		start = ESP.getCycleCount();
+		int numTimer = ISR_Timer.setInterval(500 + rep, benchCallback);
+		repCycles[0] = ESP.getCycleCount() - start;
+
+		start = ESP.getCycleCount();
+		ISR_Timer.changeInterval(numTimer, 2000 + rep);
+		repCycles[1] = ESP.getCycleCount() - start;
+
+		start = ESP.getCycleCount();
+		ISR_Timer.deleteTimer(numTimer);
+		repCycles[2] = ESP.getCycleCount() - start;
+
+		for (uint8_t op = 0; op < 3; op++)
+		{
+			cycles[op] += repCycles[op];
+
+			if (repCycles[op] > cyclesMax[op])
+				cyclesMax[op] = repCycles[op];
+		}
+	}
+
+	printSetupRow("setInterval",    numTimers, cycles[0], cyclesMax[0]);
+	printSetupRow("changeInterval", numTimers, cycles[1], cyclesMax[1]);
+	printSetupRow("deleteTimer",    numTimers, cycles[2], cyclesMax[2]);
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ISR_Timer_Benchmark on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_TIMER_INTERRUPT_VERSION);
+
+	cpuFreqMHz = ESP.getCpuFreqMHz();
+
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(cpuFreqMHz);
+	Serial.println(F(" MHz"));
+
+	printHeader();
+
+	benchSetupHardwareTimer();
+
+	for (uint8_t n = 0; n < ARRAY_SIZE(numTimersList); n++)
+		benchSetupIsrTimer(numTimersList[n]);
+
+	for (uint8_t n = 0; n < ARRAY_SIZE(numTimersList); n++)
+	{
+		for (uint8_t o = 0; o < ARRAY_SIZE(oneShotPctList); o++)
+		{
+			for (uint8_t p = 0; p < ARRAY_SIZE(periodList); p++)
+			{
+				benchRun(numTimersList[n], oneShotPctList[o], periodList[p]);
+			}
+		}
+	}
+
+	ISR_Timer.init();
+
+	Serial.println(F("Benchmark done"));
+}
+
+void loop()
+{
+}
@@ -0,0 +1,134 @@
+/****************************************************************************************************************************
+  ISR_Timer_Delegate.ino
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.2+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32, ESP32_S2, ESP32_S3, ESP32_C3 have two timer groups, TIMER_GROUP_0 and TIMER_GROUP_1
+  1) each group of ESP32, ESP32_S2, ESP32_S3 has two general purpose hardware timers, TIMER_0 and TIMER_1
+  2) each group of ESP32_C3 has ony one general purpose hardware timer, TIMER_0
+
+  All the timers are based on 64-bit counters (except 54-bit counter for ESP32_S3 counter) and 16 bit prescalers.
+  The timer counters can be configured to count up or down and support automatic reload and software reload.
+  They can also generate alarms when they reach a specific value, defined by the software.
+  The value of the counter can be read by the software program.
+
+  Now even you use all these new 16 ISR-based timers,with their maximum interval practically unlimited (limited only by
+  unsigned long miliseconds), you just consume only one ESP32-S2 timer and avoid conflicting with other cores' tasks.
+  The accuracy is nearly perfect compared to software timers. The most important feature is they're ISR-based timers
+  Therefore, their executions are not blocked by bad-behaving functions / tasks.
+  This important feature is absolutely necessary for mission-critical tasks.
+*****************************************************************************************************************************/
+
+/*
+   ISR-based timers calling member functions and lambdas with captures, stored inline in the timer slots as
+   ESP32TimerDelegate, without heap allocation nor static trampoline taking a void* parameter. Two Pulser objects run
+   at their own rates on the same ESP32_ISR_Timer, and a lambda counts into a variable it captures a pointer to.
+*/
+
+#if !defined( ESP32 )
+	#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+// These define's must be placed at the beginning before #include "ESP32TimerInterrupt.h"
+#define _TIMERINTERRUPT_LOGLEVEL_     1
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32TimerInterrupt.h"
+
+// Init ESP32 timer 0. Reserved for ISR_Timer, don't use it for anything else
+ESP32Timer ITimer0(0);
+
+// Init ESP32_ISR_Timer
+ESP32_ISR_Timer ISR_Timer;
+
+class Pulser
+{
+	public:
+		Pulser(const char* name) : name(name), numPulses(0) {}
+
+		// In ESP32, avoid doing something fancy in ISR, for example complex Serial.print with String() argument
+		// With core v2.0.0+, you can't use Serial.print/println in ISR or crash.
+		// and you can't use float calculation inside ISR
+		void IRAM_ATTR pulse()
+		{
+			numPulses++;
+		}
+
+		void print()
+		{
+			Serial.print(name);
+			Serial.print(F(" = "));
+			Serial.print(numPulses);
+		}
+
+	private:
+		const char*       name;
+		volatile uint32_t numPulses;
+};
+
+Pulser fastPulser("Fast");
+Pulser slowPulser("Slow");
+
+volatile uint32_t lambdaCount = 0;
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ISR_Timer_Delegate on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	if (ISR_Timer.attachTicklessTimer(ITimer0))
+		Serial.println(F("Starting ITimer0 OK"));
+	else
+		Serial.println(F("Can't set ITimer0. Select another timer"));
+
+	// Member function known at compile time, called directly by the delegate
+	ISR_Timer.setInterval(10L, ESP32TimerDelegate::bind<Pulser, &Pulser::pulse>(&fastPulser));
+
+	// Object and member function pointer
+	ISR_Timer.setInterval(100L, ESP32TimerDelegate(&slowPulser, &Pulser::pulse));
+
+	// Lambda capturing a pointer and a number, by value
+	volatile uint32_t* counter = &lambdaCount;
+	uint32_t           step    = 2;
+
+	ISR_Timer.setInterval(50L, [counter, step]() IRAM_ATTR
+	{
+		*counter += step;
+	});
+}
+
+#define CHECK_INTERVAL_MS     10000L
+
+void loop()
+{
+	static uint32_t lastTime = 0;
+
+	uint32_t currTime = millis();
+
+	if (currTime - lastTime > CHECK_INTERVAL_MS)
+	{
+		Serial.print(F("Time = "));
+		Serial.print(currTime);
+		Serial.print(F(", "));
+		fastPulser.print();
+		Serial.print(F(", "));
+		slowPulser.print();
+		Serial.print(F(", Lambda = "));
+		Serial.println(lambdaCount);
+
+		lastTime = currTime;
+	}
+}
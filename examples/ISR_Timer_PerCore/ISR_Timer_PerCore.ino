@@ -0,0 +1,133 @@
+/****************************************************************************************************************************
+  ISR_Timer_PerCore.ino
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.2+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32, ESP32_S2, ESP32_S3, ESP32_C3 have two timer groups, TIMER_GROUP_0 and TIMER_GROUP_1
+  1) each group of ESP32, ESP32_S2, ESP32_S3 has two general purpose hardware timers, TIMER_0 and TIMER_1
+  2) each group of ESP32_C3 has ony one general purpose hardware timer, TIMER_0
+
+  All the timers are based on 64-bit counters (except 54-bit counter for ESP32_S3 counter) and 16 bit prescalers.
+  The timer counters can be configured to count up or down and support automatic reload and software reload.
+  They can also generate alarms when they reach a specific value, defined by the software.
+  The value of the counter can be read by the software program.
+
+  Now even you use all these new 16 ISR-based timers,with their maximum interval practically unlimited (limited only by
+  unsigned long miliseconds), you just consume only one ESP32-S2 timer and avoid conflicting with other cores' tasks.
+  The accuracy is nearly perfect compared to software timers. The most important feature is they're ISR-based timers
+  Therefore, their executions are not blocked by bad-behaving functions / tasks.
+  This important feature is absolutely necessary for mission-critical tasks.
+*****************************************************************************************************************************/
+
+/*
+   Per-core ISR-based timers: a hardware timer interrupt is serviced by the core registering it, usually the one running
+   setup(), i.e. core 1 with the Arduino loop task. Here, ISR_Timers holds one ESP32_ISR_Timer per core, each driving
+   its own hardware timer in tickless operation, the interrupt of which is serviced by that core. The callbacks of the
+   timers of a shard run on its core, and print counts show it.
+
+   On single-core ESP32_S2 and ESP32_C3, only core 0 exists and attaching core 1 fails.
+*/
+
+#if !defined( ESP32 )
+	#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+// These define's must be placed at the beginning before #include "ESP32TimerInterrupt.h"
+#define _TIMERINTERRUPT_LOGLEVEL_     1
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32TimerInterrupt.h"
+
+#define TIMER_INTERVAL_10MS           10L
+#define TIMER_INTERVAL_25MS           25L
+#define TIMER_INTERVAL_1S             1000L
+
+// Init ESP32 timers 0 and 1. Reserved for ISR_Timers, don't use them for anything else
+ESP32Timer ITimer0(0);
+ESP32Timer ITimer1(1);
+
+// Init one ESP32_ISR_Timer per core
+ESP32_ISR_TimerShards ISR_Timers;
+
+// callbacks per timer and per core running them
+volatile uint32_t callCount[3][portNUM_PROCESSORS];
+
+// In ESP32, avoid doing something fancy in ISR, for example complex Serial.print with String() argument
+// With core v2.0.0+, you can't use Serial.print/println in ISR or crash.
+// and you can't use float calculation inside ISR
+void IRAM_ATTR countCall(void* timerNo)
+{
+	callCount[(uint32_t) (uintptr_t) timerNo][xPortGetCoreID()]++;
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ISR_Timer_PerCore on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	Serial.print(F("setup() running on core "));
+	Serial.println(xPortGetCoreID());
+
+	if (ISR_Timers.attach(0, ITimer0))
+		Serial.println(F("Starting ITimer0 on core 0 OK"));
+	else
+		Serial.println(F("Can't set ITimer0 on core 0. Select another timer"));
+
+	if (ISR_Timers.attach(1, ITimer1))
+		Serial.println(F("Starting ITimer1 on core 1 OK"));
+	else
+		Serial.println(F("Can't set ITimer1 on core 1"));
+
+	// The fast timers on core 0, away from the loop task
+	ISR_Timers[0].setInterval(TIMER_INTERVAL_10MS, countCall, (void *) 0);
+	ISR_Timers[0].setInterval(TIMER_INTERVAL_25MS, countCall, (void *) 1);
+
+	// Then on the core with the fewest timers
+	ISR_Timers[ISR_Timers.leastUsed()].setInterval(TIMER_INTERVAL_1S, countCall, (void *) 2);
+}
+
+#define CHECK_INTERVAL_MS     10000L
+
+void loop()
+{
+	static uint32_t lastTime = 0;
+
+	uint32_t currTime = millis();
+
+	if (currTime - lastTime > CHECK_INTERVAL_MS)
+	{
+		Serial.print(F("Time = "));
+		Serial.println(currTime);
+
+		for (uint8_t timerNo = 0; timerNo < 3; timerNo++)
+		{
+			Serial.print(F("Timer"));
+			Serial.print(timerNo);
+
+			for (uint8_t core = 0; core < portNUM_PROCESSORS; core++)
+			{
+				Serial.print(F(", core "));
+				Serial.print(core);
+				Serial.print(F(" = "));
+				Serial.print(callCount[timerNo][core]);
+			}
+
+			Serial.println();
+		}
+
+		lastTime = currTime;
+	}
+}
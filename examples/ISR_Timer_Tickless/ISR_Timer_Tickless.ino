@@ -0,0 +1,154 @@
+/****************************************************************************************************************************
+  ISR_Timer_Tickless.ino
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.2+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32, ESP32_S2, ESP32_S3, ESP32_C3 have two timer groups, TIMER_GROUP_0 and TIMER_GROUP_1
+  1) each group of ESP32, ESP32_S2, ESP32_S3 has two general purpose hardware timers, TIMER_0 and TIMER_1
+  2) each group of ESP32_C3 has ony one general purpose hardware timer, TIMER_0
+
+  All the timers are based on 64-bit counters (except 54-bit counter for ESP32_S3 counter) and 16 bit prescalers.
+  The timer counters can be configured to count up or down and support automatic reload and software reload.
+  They can also generate alarms when they reach a specific value, defined by the software.
+  The value of the counter can be read by the software program.
+
+  Now even you use all these new 16 ISR-based timers,with their maximum interval practically unlimited (limited only by
+  unsigned long miliseconds), you just consume only one ESP32-S2 timer and avoid conflicting with other cores' tasks.
+  The accuracy is nearly perfect compared to software timers. The most important feature is they're ISR-based timers
+  Therefore, their executions are not blocked by bad-behaving functions / tasks.
+  This important feature is absolutely necessary for mission-critical tasks.
+*****************************************************************************************************************************/
+
+/*
+   Notes:
+   Special design is necessary to share data between interrupt code and the rest of your program.
+   Variables usually need to be "volatile" types. Volatile tells the compiler to avoid optimizations that assume
+   variable can not spontaneously change. Because your function may change variables while your program is using them,
+   the compiler needs this hint. But volatile alone is often not enough.
+   When accessing shared variables, usually interrupts must be disabled. Even with volatile,
+   if the interrupt changes a multi-byte variable between a sequence of instructions, it can be read incorrectly.
+   If your data is multiple variables, such as an array and a count, usually interrupts need to be disabled
+   or the entire sequence of your code which accesses the data.
+*/
+
+/*
+   Tickless operation: instead of calling ISR_Timer.run() from a hardware timer interrupting at a fixed rate,
+   such as every 1ms, ISR_Timer programs the hardware timer alarm to the earliest pending deadline.
+   The hardware timer then only interrupts when an ISR-based timer is due. With the 3 timers below, that's
+   about 1.4 interrupts per second instead of 1000.
+*/
+
+#if !defined( ESP32 )
+	#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+// These define's must be placed at the beginning before #include "ESP32TimerInterrupt.h"
+#define _TIMERINTERRUPT_LOGLEVEL_     1
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32TimerInterrupt.h"
+
+#define TIMER_INTERVAL_1S             1000L
+#define TIMER_INTERVAL_2S             2000L
+#define TIMER_INTERVAL_5S             5000L
+
+// Init ESP32 timer 1. Reserved for ISR_Timer, don't use it for anything else
+ESP32Timer ITimer(1);
+
+// Init ESP32_ISR_Timer
+ESP32_ISR_Timer ISR_Timer;
+
+volatile uint32_t Timer1Count = 0;
+volatile uint32_t Timer2Count = 0;
+volatile uint32_t Timer5Count = 0;
+
+int timer2Id;
+
+// In ESP32, avoid doing something fancy in ISR, for example complex Serial.print with String() argument
+// With core v2.0.0+, you can't use Serial.print/println in ISR or crash.
+// and you can't use float calculation inside ISR
+void IRAM_ATTR doingSomething1()
+{
+	Timer1Count++;
+}
+
+void IRAM_ATTR doingSomething2()
+{
+	Timer2Count++;
+}
+
+void IRAM_ATTR doingSomething5()
+{
+	Timer5Count++;
+}
+
+void setup()
+{
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting ISR_Timer_Tickless on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	// No fixed interval here. ISR_Timer drives ITimer itself
+	if (ISR_Timer.attachTicklessTimer(ITimer))
+	{
+		Serial.print(F("Starting tickless ITimer OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer. Select another timer"));
+
+	ISR_Timer.setInterval(TIMER_INTERVAL_1S, doingSomething1);
+	timer2Id = ISR_Timer.setInterval(TIMER_INTERVAL_2S, doingSomething2);
+	ISR_Timer.setInterval(TIMER_INTERVAL_5S, doingSomething5);
+}
+
+#define CHECK_INTERVAL_MS     10000L
+#define CHANGE_INTERVAL_MS    30000L
+
+void loop()
+{
+	static uint32_t lastTime        = 0;
+	static uint32_t lastChangeTime  = 0;
+	static uint32_t multFactor      = 0;
+
+	uint32_t currTime = millis();
+
+	if (currTime - lastTime > CHECK_INTERVAL_MS)
+	{
+		Serial.print(F("Time = "));
+		Serial.print(currTime);
+		Serial.print(F(", Timer1Count = "));
+		Serial.print(Timer1Count);
+		Serial.print(F(", Timer2Count = "));
+		Serial.print(Timer2Count);
+		Serial.print(F(", Timer5Count = "));
+		Serial.println(Timer5Count);
+
+		lastTime = currTime;
+
+		// The hardware alarm is re-armed automatically when the earliest deadline moves
+		if (currTime - lastChangeTime > CHANGE_INTERVAL_MS)
+		{
+			multFactor = (multFactor + 1) % 2;
+
+			ISR_Timer.changeInterval(timer2Id, TIMER_INTERVAL_2S * (multFactor + 1));
+
+			Serial.print(F("Changing Interval, Timer2 = "));
+			Serial.println(TIMER_INTERVAL_2S * (multFactor + 1));
+
+			lastChangeTime = currTime;
+		}
+	}
+}
@@ -0,0 +1,158 @@
+/****************************************************************************************************************************
+  RPM_Capture.ino
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.2+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32TimerInterrupt
+  Licensed under MIT license
+
+  The ESP32, ESP32_S2, ESP32_S3, ESP32_C3 have two timer groups, TIMER_GROUP_0 and TIMER_GROUP_1
+  1) each group of ESP32, ESP32_S2, ESP32_S3 has two general purpose hardware timers, TIMER_0 and TIMER_1
+  2) each group of ESP32_C3 has ony one general purpose hardware timer, TIMER_0
+
+  All the timers are based on 64-bit counters (except 54-bit counter for ESP32_S3 counter) and 16 bit prescalers.
+  The timer counters can be configured to count up or down and support automatic reload and software reload.
+  They can also generate alarms when they reach a specific value, defined by the software.
+  The value of the counter can be read by the software program.
+
+  Now even you use all these new 16 ISR-based timers,with their maximum interval practically unlimited (limited only by
+  unsigned long miliseconds), you just consume only one ESP32-S2 timer and avoid conflicting with other cores' tasks.
+  The accuracy is nearly perfect compared to software timers. The most important feature is they're ISR-based timers
+  Therefore, their executions are not blocked by bad-behaving functions / tasks.
+  This important feature is absolutely necessary for mission-critical tasks.
+*****************************************************************************************************************************/
+/*
+   Notes:
+   RPM_Measure counts the time of one rotation in a 1ms timer ISR, so the resolution is 1ms, for 1000 interrupts a second.
+   Here, the hardware timer counter just runs, without interrupt, and the sensor GPIO ISR captures its value, 1us
+   resolution, into ESP32TimerCapture. loop() drains the captures and computes the rotation time between them.
+   One rotation is detected by a magnetic REED SW or IR LED Sensor. Asssuming LOW is active.
+   For example: Max speed is 600RPM => 10 RPS => minimum 100ms a rotation. We'll use 80ms for debouncing
+   RPM = 60000000 / (rotation time in us)
+*/
+
+#if !defined(ESP32)
+	#error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
+#endif
+
+// These define's must be placed at the beginning before #include "ESP32TimerInterrupt.h"
+// _TIMERINTERRUPT_LOGLEVEL_ from 0 to 4
+#define _TIMERINTERRUPT_LOGLEVEL_     0
+
+// To be included only in main(), .ino with setup() to avoid `Multiple Definitions` Linker Error
+#include "ESP32TimerInterrupt.h"
+
+// Don't use PIN_D1 in core v2.0.0 and v2.0.1. Check https://github.com/espressif/arduino-esp32/issues/5868
+// Don't use PIN_D2 with ESP32_C3 (crash)
+#define PIN_D4              4         // Pin D4 mapped to pin GPIO4/ADC10/TOUCH0 of ESP32
+
+unsigned int SWPin = PIN_D4;
+
+#define SW_CHANNEL                0
+
+#define DEBOUNCING_INTERVAL_US    80000L
+
+// If no rotation for so long, RPM = 0
+#define IDLE_INTERVAL_US          1000000L
+
+// Init ESP32 timer 0, as a free-running counter
+ESP32Timer ITimer0(0);
+
+// Events captured from the GPIO ISR
+ESP32TimerCapture Capture(ITimer0);
+
+uint64_t lastRotation = 0;
+
+float RPM       = 0;
+float avgRPM    = 0;
+
+// With core v2.0.0+, you can't use Serial.print/println in ISR or crash.
+// and you can't use float calculation inside ISR
+void IRAM_ATTR SWHandler()
+{
+	Capture.capture(SW_CHANNEL);
+}
+
+void setup()
+{
+	pinMode(SWPin, INPUT_PULLUP);
+
+	Serial.begin(115200);
+
+	while (!Serial && millis() < 5000);
+
+	delay(500);
+
+	Serial.print(F("\nStarting RPM_Capture on "));
+	Serial.println(ARDUINO_BOARD);
+	Serial.println(ESP32_TIMER_INTERRUPT_VERSION);
+	Serial.print(F("CPU Frequency = "));
+	Serial.print(F_CPU / 1000000);
+	Serial.println(F(" MHz"));
+
+	// Counter at TIMER_SCALE = 1MHz, never raising any interrupt
+	if (ITimer0.startCounter())
+	{
+		Serial.print(F("Starting  ITimer0 OK, millis() = "));
+		Serial.println(millis());
+	}
+	else
+		Serial.println(F("Can't set ITimer0. Select another timer"));
+
+	attachInterrupt(digitalPinToInterrupt(SWPin), SWHandler, FALLING);
+
+	Serial.flush();
+}
+
+#define MAX_EVENTS        16
+
+void loop()
+{
+	static unsigned long lastPrint = 0;
+
+	esp32_timer_capture_t events[MAX_EVENTS];
+
+	size_t numEvents = Capture.read(events, MAX_EVENTS);
+
+	for (size_t i = 0; i < numEvents; i++)
+	{
+		uint64_t rotationTime = events[i].ticks - lastRotation;
+
+		// Bounces of the same rotation
+		if (rotationTime < DEBOUNCING_INTERVAL_US)
+			continue;
+
+		// Not the first rotation after idle
+		if (rotationTime < IDLE_INTERVAL_US)
+		{
+			RPM     = 60000000.0f / rotationTime;
+			avgRPM  = ( 2 * avgRPM + RPM) / 3;
+		}
+
+		lastRotation = events[i].ticks;
+	}
+
+	// If idle, set RPM to 0
+	if (ITimer0.getCounter() - lastRotation >= IDLE_INTERVAL_US)
+	{
+		RPM     = 0;
+		avgRPM  = 0;
+	}
+
+	if (millis() - lastPrint >= 1000)
+	{
+		lastPrint = millis();
+
+		if (avgRPM > 0)
+		{
+			Serial.print(F("RPM  = "));
+			Serial.print(RPM);
+			Serial.print(F(", avgRPM  = "));
+			Serial.print(avgRPM);
+			Serial.print(F(", overruns = "));
+			Serial.println(Capture.getOverruns());
+		}
+	}
+
+	delay(1);
+}
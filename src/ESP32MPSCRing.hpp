@@ -0,0 +1,150 @@
+/****************************************************************************************************************************
+  ESP32MPSCRing.hpp
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.2+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32TimerInterrupt
+  Licensed under MIT license
+
+  Bounded lock-free multi-producer / single-consumer ring, for ISRs and tasks on both cores to hand data over to a single
+  consumer, without critical section. Used by ESP32_ISR_Timer's command queue and ESP32TimerCapture.
+
+  Version: 2.3.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  2.3.0   K Hoang      16/11/2022 Fix doubled time for ESP32_C3, ESP32_S2 and ESP32_S3
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef ESP32MPSCRING_HPP
+#define ESP32MPSCRING_HPP
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#if defined(ESP32_TIMER_INTERRUPT_HOST_SIM)
+  #include "ESP32TimerInterrupt_HostSim.h"
+#elif defined(ARDUINO)
+  #if ARDUINO >= 100
+    #include <Arduino.h>
+  #else
+    #include <WProgram.h>
+  #endif
+#endif
+
+// Holds up to SIZE items of T, a power of 2. T is copied, so must be trivially copyable.
+// Any number of producers, ISRs or tasks on any core, call push(). A producer claims a position by advancing head with
+// compare-and-swap, then publishes its item by the seq of the cell, so never waits for another one. Exactly one
+// consumer calls pop(), which stops at an item claimed but not written yet. Both sides are IRAM_ATTR, and the ring must
+// itself be in internal RAM
+template<typename T, size_t SIZE>
+class ESP32MPSCRing
+{
+    static_assert( (SIZE > 0) && ( (SIZE & (SIZE - 1)) == 0), "ESP32MPSCRing size must be a power of 2");
+
+  public:
+
+    ESP32MPSCRing() : head(0), tail(0)
+    {
+      // every cell ready to be written at its first lap
+      for (uint32_t pos = 0; pos < SIZE; pos++)
+        cells[pos].seq = pos;
+    };
+
+    /////////////////////////////////////////////////////////
+    // Producer side
+
+    // Returns false if full, the item being dropped
+    bool IRAM_ATTR push(const T& item)
+    {
+      uint32_t  pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+      cell_t*   cell;
+
+      while (true)
+      {
+        cell = &cells[pos & (SIZE - 1)];
+
+        // acquire : the consumer is done reading the item of the previous lap
+        int32_t diff = (int32_t) (__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - pos);
+
+        if (diff == 0)
+        {
+          // claim the position. On failure, pos is updated to the current head
+          if (__atomic_compare_exchange_n(&head, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            break;
+        }
+        else if (diff < 0)
+        {
+          // the cell still holds the item of the previous lap
+          return false;
+        }
+        else
+        {
+          // another producer claimed the position
+          pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+        }
+      }
+
+      cell->item = item;
+
+      // release : publish the item to the consumer, possibly running on the other core
+      __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+
+      return true;
+    }
+
+    /////////////////////////////////////////////////////////
+    // Consumer side
+
+    // true if the oldest item is published, i.e. pop() would succeed
+    bool IRAM_ATTR isReady() const
+    {
+      return ( __atomic_load_n(&cells[tail & (SIZE - 1)].seq, __ATOMIC_ACQUIRE) == tail + 1 );
+    }
+
+    // Returns false if empty, or if the oldest item is claimed but not written yet
+    bool IRAM_ATTR pop(T& item)
+    {
+      if (!isReady())
+        return false;
+
+      cell_t* cell = &cells[tail & (SIZE - 1)];
+
+      item = cell->item;
+
+      // release : free the cell for the next lap, the item being read
+      __atomic_store_n(&cell->seq, tail + SIZE, __ATOMIC_RELEASE);
+      tail++;
+
+      return true;
+    }
+
+    // Number of items claimed by the producers and not popped yet, including the ones still being written
+    size_t available() const
+    {
+      return (size_t) (__atomic_load_n(&head, __ATOMIC_RELAXED) - tail);
+    }
+
+    static constexpr size_t capacity()
+    {
+      return SIZE;
+    }
+
+  private:
+
+    typedef struct
+    {
+      volatile uint32_t seq;      // position it's ready to be written at, position + 1 once written
+      T                 item;
+    } cell_t;
+
+    cell_t            cells[SIZE];
+
+    // head is advanced by the producers, tail only by the consumer. They count items forever, wrapping around
+    volatile uint32_t head;
+    uint32_t          tail;
+};
+
+#endif    // ESP32MPSCRING_HPP
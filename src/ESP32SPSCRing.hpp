@@ -0,0 +1,160 @@
+/****************************************************************************************************************************
+  ESP32SPSCRing.hpp
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.2+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32TimerInterrupt
+  Licensed under MIT license
+
+  Wait-free single-producer / single-consumer ring, to hand data over from an ISR to a task, or the other way round,
+  possibly running on the other core, without critical section nor torn multi-byte values.
+
+  Version: 2.3.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  2.3.0   K Hoang      16/11/2022 Fix doubled time for ESP32_C3, ESP32_S2 and ESP32_S3
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef ESP32SPSCRING_HPP
+#define ESP32SPSCRING_HPP
+
+#include <stddef.h>
+#include <inttypes.h>
+
+#if defined(ESP32_TIMER_INTERRUPT_HOST_SIM)
+  #include "ESP32TimerInterrupt_HostSim.h"
+#elif defined(ARDUINO)
+  #if ARDUINO >= 100
+    #include <Arduino.h>
+  #else
+    #include <WProgram.h>
+  #endif
+#endif
+
+// Holds up to SIZE items of T, a power of 2. T is copied, so must be trivially copyable.
+// Exactly one producer, e.g. an ISR, calls push(), and exactly one consumer, e.g. loop(), calls pop(). The producer
+// side is IRAM_ATTR, so can push while the flash cache is disabled. The ring must itself be in internal RAM, e.g. a
+// global, not in PSRAM.
+//
+// Example :
+//
+//   ESP32SPSCRing<sample_t, 64> samples;
+//
+//   bool IRAM_ATTR TimerHandler(void * timerNo)    { samples.push(readSample()); return true; }
+//   void loop()                                    { sample_t s; while (samples.pop(s)) process(s); }
+template<typename T, size_t SIZE>
+class ESP32SPSCRing
+{
+    static_assert( (SIZE > 0) && ( (SIZE & (SIZE - 1)) == 0), "ESP32SPSCRing size must be a power of 2");
+
+  public:
+
+    ESP32SPSCRing() : head(0), tail(0)
+    {
+    };
+
+    /////////////////////////////////////////////////////////
+    // Producer side
+
+    // Returns false if full, the item being dropped
+    bool IRAM_ATTR push(const T& item)
+    {
+      uint32_t pos = head;
+
+      // acquire : the consumer is done reading the item it freed
+      if ( (pos - __atomic_load_n(&tail, __ATOMIC_ACQUIRE)) >= SIZE )
+        return false;
+
+      items[pos & (SIZE - 1)] = item;
+
+      // release : publish the item to the consumer, possibly running on the other core
+      __atomic_store_n(&head, pos + 1, __ATOMIC_RELEASE);
+
+      return true;
+    }
+
+    // Push up to 'count' items, in order, with a single publication. Returns the number pushed, less if full
+    size_t IRAM_ATTR push(const T* newItems, const size_t& count)
+    {
+      uint32_t pos  = head;
+      size_t   room = SIZE - (pos - __atomic_load_n(&tail, __ATOMIC_ACQUIRE));
+      size_t   n    = (count < room) ? count : room;
+
+      for (size_t i = 0; i < n; i++)
+        items[(pos + i) & (SIZE - 1)] = newItems[i];
+
+      __atomic_store_n(&head, pos + n, __ATOMIC_RELEASE);
+
+      return n;
+    }
+
+    // Free room, at least as much as this for the producer
+    size_t IRAM_ATTR room() const
+    {
+      return SIZE - (head - __atomic_load_n(&tail, __ATOMIC_ACQUIRE));
+    }
+
+    /////////////////////////////////////////////////////////
+    // Consumer side
+
+    // Returns false if empty
+    bool pop(T& item)
+    {
+      uint32_t pos = tail;
+
+      // acquire : the item published by the producer is visible
+      if (pos == __atomic_load_n(&head, __ATOMIC_ACQUIRE))
+        return false;
+
+      item = items[pos & (SIZE - 1)];
+
+      // release : the item is read, the producer can reuse its place
+      __atomic_store_n(&tail, pos + 1, __ATOMIC_RELEASE);
+
+      return true;
+    }
+
+    // Pop up to 'maxCount' items, oldest first, freeing their places at once. Returns the number popped
+    size_t pop(T* outItems, const size_t& maxCount)
+    {
+      uint32_t pos  = tail;
+      size_t   used = __atomic_load_n(&head, __ATOMIC_ACQUIRE) - pos;
+      size_t   n    = (maxCount < used) ? maxCount : used;
+
+      for (size_t i = 0; i < n; i++)
+        outItems[i] = items[(pos + i) & (SIZE - 1)];
+
+      __atomic_store_n(&tail, pos + n, __ATOMIC_RELEASE);
+
+      return n;
+    }
+
+    // Number of items waiting, at least as many as this for the consumer
+    size_t available() const
+    {
+      return __atomic_load_n(&head, __ATOMIC_ACQUIRE) - tail;
+    }
+
+    bool isEmpty() const
+    {
+      return (available() == 0);
+    }
+
+    static constexpr size_t capacity()
+    {
+      return SIZE;
+    }
+
+  private:
+
+    T                 items[SIZE];
+
+    // head is only written by the producer, tail only by the consumer. They count items forever, wrapping around
+    volatile uint32_t head;
+    volatile uint32_t tail;
+};
+
+#endif    // ESP32SPSCRING_HPP
@@ -0,0 +1,112 @@
+/****************************************************************************************************************************
+  ESP32TimerCapture.hpp
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.2+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32TimerInterrupt
+  Licensed under MIT license
+
+  Event timestamp capture. GPIO or other ISRs record (channel, counter value) pairs of a running ESP32TimerInterrupt
+  into a preallocated lock-free ring, drained in batches by a task. Periods and frequencies are then measured to the
+  counter tick, 1us by default, without any polling timer interrupt.
+
+  Version: 2.3.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  2.3.0   K Hoang      16/11/2022 Fix doubled time for ESP32_C3, ESP32_S2 and ESP32_S3
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef ESP32TIMERCAPTURE_HPP
+#define ESP32TIMERCAPTURE_HPP
+
+#include "ESP32MPSCRing.hpp"
+
+// Default number of events ESP32TimerCapture holds. Must be a power of 2
+#ifndef ESP32_TIMER_CAPTURE_SIZE
+  #define ESP32_TIMER_CAPTURE_SIZE          64
+#endif
+
+typedef struct
+{
+  uint64_t  ticks;          // counter value of the hardware timer at capture()
+  uint8_t   channel;        // as given to capture()
+} esp32_timer_capture_t;
+
+// Holds up to SIZE events. The hardware timer must be running a counter never reloaded, i.e. started by startCounter(),
+// attachInterruptOneShot() or attachInterruptFreeRunning(), for the timestamps to be comparable
+template<size_t SIZE>
+class ESP32TimerCaptureT
+{
+    static_assert( (SIZE & (SIZE - 1)) == 0, "ESP32TimerCapture size must be a power of 2");
+
+  public:
+
+    ESP32TimerCaptureT(ESP32TimerInterrupt& hwTimer) : hwTimer(hwTimer), overruns(0)
+    {
+    }
+
+    // Record an event of 'channel', timestamped with the hardware timer counter. Callable from ISRs, e.g. GPIO ones,
+    // and tasks, on any core. Returns false, counting an overrun, if the ring is full.
+    // Events captured at the same time on both cores may be stored a few ticks out of order
+    bool IRAM_ATTR capture(const uint8_t& channel)
+    {
+      esp32_timer_capture_t event;
+
+      event.ticks   = hwTimer.getCounter();
+      event.channel = channel;
+
+      if (!ring.push(event))
+      {
+        __atomic_fetch_add(&overruns, 1, __ATOMIC_RELAXED);
+
+        return false;
+      }
+
+      return true;
+    }
+
+    // Move up to 'maxEvents' events into 'events', oldest first. Single consumer, a task.
+    // Returns the number of events moved, stopping at one claimed but not written yet
+    size_t read(esp32_timer_capture_t* events, const size_t& maxEvents)
+    {
+      size_t numEvents = 0;
+
+      while ( (numEvents < maxEvents) && ring.pop(events[numEvents]) )
+        numEvents++;
+
+      return numEvents;
+    }
+
+    // Number of events waiting to be read
+    size_t available()
+    {
+      return ring.available();
+    }
+
+    // Number of events lost to a full ring since the start, or resetOverruns()
+    uint32_t getOverruns() __attribute__((always_inline))
+    {
+      return __atomic_load_n(&overruns, __ATOMIC_RELAXED);
+    };
+
+    void resetOverruns()
+    {
+      __atomic_store_n(&overruns, 0, __ATOMIC_RELAXED);
+    }
+
+  private:
+
+    ESP32TimerInterrupt& hwTimer;
+
+    // Filled by capture() from any ISR or task, drained by read()
+    ESP32MPSCRing<esp32_timer_capture_t, SIZE>   ring;
+
+    volatile uint32_t overruns;
+};
+
+typedef ESP32TimerCaptureT<ESP32_TIMER_CAPTURE_SIZE>   ESP32TimerCapture;
+
+#endif    // ESP32TIMERCAPTURE_HPP
@@ -0,0 +1,231 @@
+/****************************************************************************************************************************
+  ESP32TimerDelegate.hpp
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.2+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32TimerInterrupt
+  Licensed under MIT license
+
+  Fixed-size callable stored by value, to call plain functions, lambdas with captures and member functions from
+  ISR-based timers, without heap allocation nor user-written trampolines.
+
+  Version: 2.3.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  2.3.0   K Hoang      16/11/2022 Fix doubled time for ESP32_C3, ESP32_S2 and ESP32_S3
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef ESP32TIMERDELEGATE_HPP
+#define ESP32TIMERDELEGATE_HPP
+
+#include <stddef.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include <new>
+#include <type_traits>
+
+#if defined(ESP32_TIMER_INTERRUPT_HOST_SIM)
+  #include "ESP32TimerInterrupt_HostSim.h"
+#elif defined(ARDUINO)
+  #if ARDUINO >= 100
+    #include <Arduino.h>
+  #else
+    #include <WProgram.h>
+  #endif
+#endif
+
+#if !defined(ESP32_TIMER_INTERRUPT_HOST_SIM)
+  #include <soc/soc_memory_layout.h>
+#endif
+
+// Bytes of captured data an ESP32TimerDelegate holds. The default fits an object and a member function pointer
+#ifndef ESP32_TIMER_DELEGATE_SIZE
+  #define ESP32_TIMER_DELEGATE_SIZE     (3 * sizeof(void *))
+#endif
+
+// Callable stored inline. A function void f() is called directly, anything else through a single function pointer, the
+// invoker, specialized for what is stored. Holds one of :
+//   - a function, void f() or void f(void *) and its parameter
+//   - a lambda with captures, up to ESP32_TIMER_DELEGATE_SIZE bytes, trivially copyable: pointers, numbers, ...
+//     but no String. A captureless lambda is stored as a function
+//   - an object and a member function void C::f(), ESP32TimerDelegate(this, &C::f), or
+//     ESP32TimerDelegate::bind<C, &C::f>(this) to have the member function called directly by the invoker
+// Copied by value, e.g. into the dispatch queue, so what the lambda captures by reference must outlive the timer.
+// For an IRAM-safe timer interrupt, lambdas must be declared [...]() IRAM_ATTR { ... } and member functions IRAM_ATTR
+class ESP32TimerDelegate
+{
+  public:
+
+    // empty, never called
+    ESP32TimerDelegate() : storage(), invoker(NULL)
+    {
+    };
+
+    // NULL makes an empty delegate
+    ESP32TimerDelegate(void (*function)()) : invoker(function ? invokeFunction : NULL)
+    {
+      new (&storage) function_t(function);
+    };
+
+    ESP32TimerDelegate(void (*function)(void *), void* param) : invoker(function ? invokeFunctionParam : NULL)
+    {
+      function_param_t bound = { function, param };
+
+      new (&storage) function_param_t(bound);
+    };
+
+    template < typename FUNCTOR, typename = typename std::enable_if < !std::is_convertible<FUNCTOR, void (*)()>::value >::type >
+    ESP32TimerDelegate(const FUNCTOR& functor) : invoker(invokeFunctor<FUNCTOR>)
+    {
+      static_assert(sizeof(FUNCTOR) <= ESP32_TIMER_DELEGATE_SIZE,
+                    "Lambda captures too large for ESP32TimerDelegate, increase ESP32_TIMER_DELEGATE_SIZE");
+      static_assert(alignof(FUNCTOR) <= alignof(storage_t), "Lambda captures over-aligned for ESP32TimerDelegate");
+      static_assert(std::is_trivially_copyable<FUNCTOR>::value,
+                    "Lambda captures must be trivially copyable for ESP32TimerDelegate, e.g. pointers and numbers");
+
+      new (&storage) FUNCTOR(functor);
+    };
+
+    // A member function not in IRAM, or virtual, gets an invoker in flash, so that isInIRAM() reports it
+    template<typename C>
+    ESP32TimerDelegate(C* object, void (C::*method)())
+      : invoker(object ? (isMethodInIRAM(method) ? invokeMember<C> : invokeMemberInFlash<C>) : NULL)
+    {
+      static_assert(sizeof(member_t<C>) <= ESP32_TIMER_DELEGATE_SIZE,
+                    "Member function pointer too large for ESP32TimerDelegate, increase ESP32_TIMER_DELEGATE_SIZE");
+
+      member_t<C> member = { object, method };
+
+      new (&storage) member_t<C>(member);
+    };
+
+    // Member function known at compile time, e.g. ESP32TimerDelegate::bind<MyClass, &MyClass::onTimer>(this)
+    template<typename C, void (C::*METHOD)()>
+    static ESP32TimerDelegate bind(C* object)
+    {
+      ESP32TimerDelegate delegate;
+
+      if (object != NULL)
+      {
+        delegate.invoker = invokeBound<C, METHOD>;
+        new (&delegate.storage) C* (object);
+      }
+
+      return delegate;
+    };
+
+    void IRAM_ATTR operator()() __attribute__((always_inline))
+    {
+      // invokeFunction only marks a function void f(), called without going through it
+      if (invoker == invokeFunction)
+        (*(function_t*) &storage)();
+      else
+        invoker(&storage);
+    };
+
+    bool isEmpty() const __attribute__((always_inline))
+    {
+      return (invoker == NULL);
+    };
+
+    // The function called, or the invoker for lambdas and member functions, which inlines them. NULL if empty
+    const void* IRAM_ATTR target() const
+    {
+      if (invoker == invokeFunction)
+        return (const void *) * (const function_t*) &storage;
+      else if (invoker == invokeFunctionParam)
+        return (const void *) ((const function_param_t*) &storage)->function;
+
+      return (const void *) invoker;
+    };
+
+    // true if callable while the flash cache is disabled. Lambdas and bind() member functions not inlined into the
+    // invoker can't be checked
+    bool isInIRAM() const
+    {
+      return ( !isEmpty() && esp_ptr_in_iram((const void *) invoker) && esp_ptr_in_iram(target()) );
+    };
+
+  private:
+
+    typedef void (*invoker_t)(void *);
+
+    typedef void (*function_t)();
+
+    typedef struct
+    {
+      void (*function)(void *);
+      void*  param;
+    } function_param_t;
+
+    template<typename C>
+    struct member_t
+    {
+      C*     object;
+      void (C::*method)();
+    };
+
+    typedef typename std::aligned_storage<ESP32_TIMER_DELEGATE_SIZE, alignof(void *)>::type   storage_t;
+
+    static void IRAM_ATTR invokeFunction(void* data)
+    {
+      (*(function_t*) data)();
+    };
+
+    static void IRAM_ATTR invokeFunctionParam(void* data)
+    {
+      function_param_t* bound = (function_param_t*) data;
+
+      bound->function(bound->param);
+    };
+
+    template<typename FUNCTOR>
+    static void IRAM_ATTR invokeFunctor(void* data)
+    {
+      (*(FUNCTOR*) data)();
+    };
+
+    template<typename C>
+    static void IRAM_ATTR invokeMember(void* data)
+    {
+      member_t<C>* member = (member_t<C>*) data;
+
+      (member->object->*member->method)();
+    };
+
+    template<typename C>
+    static void invokeMemberInFlash(void* data)
+    {
+      member_t<C>* member = (member_t<C>*) data;
+
+      (member->object->*member->method)();
+    };
+
+    // The first word of a member function pointer is the function address, or 1 + its vtable offset if virtual
+    // (Itanium C++ ABI, as used by GCC for Xtensa and RISC-V). A virtual one can't be checked
+    template<typename C>
+    static bool isMethodInIRAM(void (C::*method)())
+    {
+      uintptr_t code;
+
+      memcpy(&code, &method, sizeof (code));
+
+      return ( !(code & 1) && esp_ptr_in_iram((const void *) code) );
+    };
+
+    template<typename C, void (C::*METHOD)()>
+    static void IRAM_ATTR invokeBound(void* data)
+    {
+      ((*(C**) data)->*METHOD)();
+    };
+
+    // first, so that no padding is needed before invoker
+    storage_t storage;
+    invoker_t invoker;
+};
+
+#endif    // ESP32TIMERDELEGATE_HPP
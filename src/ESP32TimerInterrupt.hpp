@@ -57,7 +57,14 @@
 #ifndef ESP32TIMERINTERRUPT_HPP
 #define ESP32TIMERINTERRUPT_HPP
 
-#if ( ARDUINO_ESP32S2_DEV || ARDUINO_FEATHERS2 || ARDUINO_ESP32S2_THING_PLUS || ARDUINO_MICROS2 || \
+#if defined(ESP32_TIMER_INTERRUPT_HOST_SIM)
+  // Host build, against the simulated ESP32 of ESP32TimerInterrupt_HostSim.h
+  #define USING_ESP32_TIMERINTERRUPT            true
+  
+  #if (_TIMERINTERRUPT_LOGLEVEL_ > 3)
+    #warning USING_ESP32_TIMERINTERRUPT with ESP32_TIMER_INTERRUPT_HOST_SIM
+  #endif
+#elif ( ARDUINO_ESP32S2_DEV || ARDUINO_FEATHERS2 || ARDUINO_ESP32S2_THING_PLUS || ARDUINO_MICROS2 || \
       ARDUINO_METRO_ESP32S2 || ARDUINO_MAGTAG29_ESP32S2 || ARDUINO_FUNHOUSE_ESP32S2 || \
       ARDUINO_ADAFRUIT_FEATHER_ESP32S2_NOPSRAM || ARDUINO_ADAFRUIT_QTPY_ESP32S2 || ARDUINO_ESP32S2_USB || \
       ARDUINO_FEATHERS2NEO || ARDUINO_TINYS2 || ARDUINO_RMP || ARDUINO_LOLIN_S2_MINI || ARDUINO_LOLIN_S2_PICO || \
@@ -109,7 +116,9 @@
   #define TIMER_INTERRUPT_DEBUG      0
 #endif
 
-#if defined(ARDUINO)
+#if defined(ESP32_TIMER_INTERRUPT_HOST_SIM)
+  #include "ESP32TimerInterrupt_HostSim.h"
+#elif defined(ARDUINO)
   #if ARDUINO >= 100
     #include <Arduino.h>
   #else
@@ -119,7 +128,17 @@
 
 #include "TimerInterrupt_Generic_Debug.h"
 
-#include <driver/timer.h>
+#if !defined(ESP32_TIMER_INTERRUPT_HOST_SIM)
+  #include <driver/timer.h>
+
+  // esp_ptr_in_iram(), to check that callbacks of IRAM-safe interrupts are in IRAM
+  #include <soc/soc_memory_layout.h>
+
+  #if (portNUM_PROCESSORS > 1)
+    // to allocate timer interrupts on the other core
+    #include <esp_ipc.h>
+  #endif
+#endif
 
 /*
   //ESP32 core v1.0.6, hw_timer_t defined in esp32/tools/sdk/include/driver/driver/timer.h:
@@ -242,10 +261,27 @@ typedef ESP32TimerInterrupt ESP32Timer;
   #define MAX_ESP32_NUM_TIMERS      				4
 #endif
 
+// Interrupt levels accepted by setInterruptLevel(). Higher levels need handlers written in assembly, which
+// timer_isr_callback_add() can't register. TIMER_INTR_LEVEL_DEFAULT lets the driver pick a free level among 1-3
+#define TIMER_INTR_LEVEL_DEFAULT                0
+#define TIMER_INTR_LEVEL_MAX                    3
+
 #define TIMER_DIVIDER             					80			//  Hardware timer clock divider
+
+// Range of the hardware timer clock divider, and setDivider() value to choose it per period
+#define TIMER_DIVIDER_MIN                       2
+#define TIMER_DIVIDER_MAX                       65536
+#define TIMER_DIVIDER_AUTO                      0
 // TIMER_BASE_CLK = APB_CLK_FREQ = Frequency of the clock on the input of the timer groups
 #define TIMER_SCALE               (TIMER_BASE_CLK / TIMER_DIVIDER)  // convert counter value to seconds
 
+// Minimum distance, in TIMER_BASE_CLK cycles, between the current counter value and a new alarm set by setAlarmAfter(),
+// armAt() or updatePeriodXXX(), so that the alarm is never programmed in the past while being written. Converted to
+// counter ticks with the divider in use, rounded up. 10us at 80MHz
+#ifndef TIMER_MIN_ALARM_CYCLES
+  #define TIMER_MIN_ALARM_CYCLES    800
+#endif
+
 
 // In esp32/1.0.6/tools/sdk/esp32s2/include/driver/include/driver/timer.h
 // typedef bool (*timer_isr_t)(void *);
@@ -301,14 +337,260 @@ class ESP32TimerInterrupt
     esp32_timer_callback _callback;        // pointer to the callback function
     float             _frequency;       // Timer frequency
     uint64_t          _timerCount;      // count to activate timer
+
+    BaseType_t        _core;            // core servicing the interrupt, tskNO_AFFINITY for the attaching one
+    uint32_t          _divider;         // clock divider, fixed 2-65536, or TIMER_DIVIDER_AUTO
+    uint32_t          _counterDivider;  // clock divider in use by the counter
+
+    // Last period requested, q + r / 1e9 TIMER_BASE_CLK cycles, and the count programmed for it with _counterDivider.
+    // Kept as integers, as updatePeriodXXX() may run in an ISR, where float isn't allowed : getPeriodError() computes
+    // the error from them. All 0 in free-running mode
+    uint64_t          _requestedQ;
+    uint32_t          _requestedR;
+    uint64_t          _requestedCount;
+
+    // Period for updatePeriodXXX(), programmed by periodicHandler() at the next period boundary
+    volatile bool     _periodPending;
+    uint64_t          _pendingCount;
+
+    uint64_t          _alarmTicks;      // counter value requested by the last armAt() / armAfter()
+
+    // Protects the alarm programming, and the above
+    portMUX_TYPE      _alarmMux = portMUX_INITIALIZER_UNLOCKED;
+    uint8_t           _intrLevel;       // interrupt level, TIMER_INTR_LEVEL_DEFAULT for any of 1-3
+    bool              _intrIRAM;        // interrupt kept enabled while the flash cache is disabled
     
     //xQueueHandle      s_timer_queue;
 
+    typedef struct
+    {
+      ESP32TimerInterrupt*  hwTimer;
+      esp32_timer_callback  handler;
+      void*                 arg;
+      esp_err_t             err;
+    } isr_add_args_t;
+
+    // TIMER_MIN_ALARM_CYCLES in ticks of the counter, at least 1
+    uint64_t IRAM_ATTR minAlarmTicks() __attribute__((always_inline))
+    {
+      uint64_t ticks = ( (uint64_t) TIMER_MIN_ALARM_CYCLES + _counterDivider - 1) / _counterDivider;
+
+      return (ticks > 0) ? ticks : 1;
+    }
+
+    // _alarmMux is taken from both tasks and ISRs, updatePeriodXXX() and armAt() being callable from either
+    void IRAM_ATTR enterAlarmCritical() __attribute__((always_inline))
+    {
+      // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+      if (xPortInIsrContext())
+        portENTER_CRITICAL_ISR(&_alarmMux);
+      else
+        portENTER_CRITICAL(&_alarmMux);
+    }
+
+    void IRAM_ATTR exitAlarmCritical() __attribute__((always_inline))
+    {
+      // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+      if (xPortInIsrContext())
+        portEXIT_CRITICAL_ISR(&_alarmMux);
+      else
+        portEXIT_CRITICAL(&_alarmMux);
+    }
+
+    void IRAM_ATTR setRequested(const uint64_t& count, const uint64_t& q, const uint32_t& r) __attribute__((always_inline))
+    {
+      _requestedCount = count;
+      _requestedQ     = q;
+      _requestedR     = r;
+    }
+
+    // updatePeriodXXX() of 'count' ticks, for a period of q + r / 1e9 TIMER_BASE_CLK cycles requested. Task or ISR
+    bool IRAM_ATTR updatePeriodCount(const uint64_t& count, const uint64_t& q, const uint32_t& r)
+    {
+      if ( (count < minAlarmTicks()) || (_timerCount == 0) )
+      {
+        return false;
+      }
+
+      enterAlarmCritical();
+
+      _pendingCount   = count;
+      _periodPending  = true;
+
+      setRequested(count, q, r);
+
+      exitAlarmCritical();
+
+      return true;
+    }
+
+    static void isrCallbackAddOnCore(void* args)
+    {
+      isr_add_args_t* addArgs = (isr_add_args_t*) args;
+
+      addArgs->err = timer_isr_callback_add(addArgs->hwTimer->_timerGroup, addArgs->hwTimer->_timerIndex,
+                                            addArgs->handler, addArgs->arg, addArgs->hwTimer->intrAllocFlags());
+    }
+
+    // ISR of the periodic modes. 'arg' is the ESP32TimerInterrupt. The counter has just been reloaded: a period
+    // requested by updatePeriodXXX(), even from _callback, ends the one starting now
+    static bool IRAM_ATTR periodicHandler(void* arg)
+    {
+      ESP32TimerInterrupt* hwTimer = (ESP32TimerInterrupt*) arg;
+
+      bool yield = hwTimer->_callback((void *) (uintptr_t) hwTimer->_timerNo);
+
+      if (hwTimer->_periodPending)
+      {
+        // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+        portENTER_CRITICAL_ISR(&hwTimer->_alarmMux);
+
+        uint64_t counter  = timer_group_get_counter_value_in_isr(hwTimer->_timerGroup, hwTimer->_timerIndex);
+
+        if (hwTimer->_pendingCount >= counter + hwTimer->minAlarmTicks())
+        {
+          timer_group_set_alarm_value_in_isr(hwTimer->_timerGroup, hwTimer->_timerIndex, hwTimer->_pendingCount);
+
+          hwTimer->_timerCount    = hwTimer->_pendingCount;
+          hwTimer->_periodPending = false;
+        }
+        else
+        {
+          // The new period is already over, e.g. after a slow _callback. The alarm must never be set in the past : end
+          // this period as soon as possible, and try again at the next boundary
+          timer_group_set_alarm_value_in_isr(hwTimer->_timerGroup, hwTimer->_timerIndex,
+                                             counter + hwTimer->minAlarmTicks());
+        }
+
+        // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+        portEXIT_CRITICAL_ISR(&hwTimer->_alarmMux);
+      }
+
+      return yield;
+    }
+
+    // ESP_INTR_FLAG_XXX for _intrLevel and _intrIRAM
+    int intrAllocFlags()
+    {
+      int flags = (_intrLevel == TIMER_INTR_LEVEL_DEFAULT) ? ESP_INTR_FLAG_LOWMED : (ESP_INTR_FLAG_LEVEL1 << (_intrLevel - 1));
+
+      if (_intrIRAM)
+        flags |= ESP_INTR_FLAG_IRAM;
+
+      return flags;
+    }
+
+    // With ESP_INTR_FLAG_IRAM, the callback runs while the flash cache is disabled, and must be IRAM_ATTR
+    bool checkCallback(const esp32_timer_callback& callback)
+    {
+      if (_intrIRAM && !esp_ptr_in_iram((const void *) callback))
+      {
+        TISR_LOGERROR(F("Error. IRAM-safe interrupt, callback must be IRAM_ATTR"));
+
+        return false;
+      }
+
+      return true;
+    }
+
+    // Register 'handler'. The driver allocates the interrupt on the calling core, so have _core call it
+    esp_err_t isrCallbackAdd(const esp32_timer_callback& handler, void* arg)
+    {
+      isr_add_args_t args = { this, handler, arg, ESP_OK };
+
+#if (portNUM_PROCESSORS > 1)
+      if ( (_core != tskNO_AFFINITY) && (_core != (BaseType_t) xPortGetCoreID()) )
+      {
+        if (esp_ipc_call_blocking(_core, isrCallbackAddOnCore, &args) != ESP_OK)
+          args.err = ESP_FAIL;
+      }
+      else
+#endif
+      {
+        isrCallbackAddOnCore(&args);
+      }
+
+      if (args.err != ESP_OK)
+      {
+        TISR_LOGERROR1(F("Error. Can't register timer interrupt, err ="), args.err);
+      }
+
+      return args.err;
+    }
+
+    // Number of TIMER_BASE_CLK / divider ticks nearest to a period of q + r / 1e9 TIMER_BASE_CLK cycles
+    static uint64_t IRAM_ATTR nearestCount(const uint64_t& q, const uint32_t& r, const uint32_t& divider)
+    {
+      uint64_t rem = q % divider;
+
+      // round up if rem + r / 1e9 >= divider / 2
+      return q / divider + ( (2 * (rem * 1000000000ULL + r) >= (uint64_t) divider * 1000000000ULL) ? 1 : 0 );
+    }
+
+    // (programmed - requested) / requested, for 'count' ticks of TIMER_BASE_CLK / divider and a period of q + r / 1e9
+    // TIMER_BASE_CLK cycles requested
+    static float periodError(const uint64_t& count, const uint32_t& divider, const uint64_t& q, const uint32_t& r)
+    {
+      // in units of 1e-9 cycle, the difference being less than a divider
+      return (float) ( (int64_t) (count * divider - q) * 1000000000LL - (int64_t) r ) / ( (float) q * 1e9f + (float) r );
+    }
+
+    // Smallest divider programming a period of q + r / 1e9 TIMER_BASE_CLK cycles with the least error. The error can't be
+    // less than the distance to the nearest whole number of cycles, reached by any divider of it. Failing that, the next
+    // best are the two neighbouring numbers of cycles, even, so reached by a divider of 2
+    static uint32_t bestDivider(const uint64_t& q, const uint32_t& r)
+    {
+      uint64_t cycles = q + ( (r >= 500000000UL) ? 1 : 0 );
+
+      if ( (cycles & 1) == 0 )
+        return TIMER_DIVIDER_MIN;
+
+      uint32_t maxDivider = (cycles < TIMER_DIVIDER_MAX) ? (uint32_t) cycles : TIMER_DIVIDER_MAX;
+
+      // Odd number of cycles, odd dividers only. Avoid the slower 64-bit modulo when possible
+      if (cycles <= UINT32_MAX)
+      {
+        for (uint32_t divider = 3; divider <= maxDivider; divider += 2)
+        {
+          if ( ( (uint32_t) cycles % divider) == 0 )
+            return divider;
+        }
+      }
+      else
+      {
+        for (uint32_t divider = 3; divider <= maxDivider; divider += 2)
+        {
+          if ( (cycles % divider) == 0 )
+            return divider;
+        }
+      }
+
+      return TIMER_DIVIDER_MIN;
+    }
+
   public:
 
-    ESP32TimerInterrupt(const uint8_t& timerNo)
+    // intrLevel : interrupt level, 1-3, or TIMER_INTR_LEVEL_DEFAULT for any free one
+    // intrIRAM  : keep the interrupt enabled while the flash cache is disabled (NVS / SPIFFS writes, OTA). The
+    //             callback and everything it calls must then be in IRAM (IRAM_ATTR) or ROM, and its data in DRAM
+    ESP32TimerInterrupt(const uint8_t& timerNo, const uint8_t& intrLevel = TIMER_INTR_LEVEL_DEFAULT,
+                        const bool& intrIRAM = false)
     {     
-      _callback = NULL;
+      _callback   = NULL;
+      _core       = tskNO_AFFINITY;
+      _intrLevel  = TIMER_INTR_LEVEL_DEFAULT;
+      _intrIRAM   = intrIRAM;
+
+      _divider        = TIMER_DIVIDER;
+      _counterDivider = TIMER_DIVIDER;
+      _timerCount     = 0;
+      _periodPending  = false;
+
+      setRequested(0, 0, 0);
+
+      _alarmTicks     = 0;
+
+      setInterruptLevel(intrLevel);
         
       if (timerNo < MAX_ESP32_NUM_TIMERS)
       {
@@ -336,46 +618,67 @@ class ESP32TimerInterrupt
       }
     };
 
-    // frequency (in hertz) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
-    // No params and duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
-    bool setFrequency(const float& frequency, const esp32_timer_callback& callback)
+    // Interrupt every 'count' ticks of TIMER_BASE_CLK / divider. The period requested was q + r / 1e9 TIMER_BASE_CLK
+    // cycles, for getPeriodError(). Returns false for a zero count
+    bool startPeriodic(const uint32_t& divider, const uint64_t& count, const uint64_t& q, const uint32_t& r,
+                       const esp32_timer_callback& callback)
     {
       if (_timerNo < MAX_ESP32_NUM_TIMERS)
       {      
-        // select timer frequency is 1MHz for better accuracy. We don't use 16-bit prescaler for now.
-        // Will use later if very low frequency is needed.
-        _frequency  = TIMER_BASE_CLK / TIMER_DIVIDER;   //1000000;
-        _timerCount = (uint64_t) _frequency / frequency;
+        if (count == 0)
+        {
+          TISR_LOGERROR(F("Error. Period must be at least 1 tick"));
+
+          return false;
+        }
+
+        if (!checkCallback(callback))
+        {
+          return false;
+        }
+
+        // 1MHz with the default TIMER_DIVIDER
+        _frequency      = TIMER_BASE_CLK / divider;
+        _counterDivider = divider;
+        _timerCount     = count;
         // count up
 
+        _periodPending  = false;
+
+        setRequested(count, q, r);
+
 #if USING_ESP32_S2_TIMERINTERRUPT
-        TISR_LOGWARN3(F("ESP32_S2_TimerInterrupt: _timerNo ="), _timerNo, F(", _fre ="), TIMER_BASE_CLK / TIMER_DIVIDER);
-        TISR_LOGWARN3(F("TIMER_BASE_CLK ="), TIMER_BASE_CLK, F(", TIMER_DIVIDER ="), TIMER_DIVIDER);
+        TISR_LOGWARN3(F("ESP32_S2_TimerInterrupt: _timerNo ="), _timerNo, F(", _fre ="), TIMER_BASE_CLK / divider);
+        TISR_LOGWARN3(F("TIMER_BASE_CLK ="), TIMER_BASE_CLK, F(", divider ="), divider);
         TISR_LOGWARN3(F("_timerIndex ="), _timerIndex, F(", _timerGroup ="), _timerGroup);
         TISR_LOGWARN3(F("_count ="), (uint32_t) (_timerCount >> 32) , F("-"), (uint32_t) (_timerCount));
-        TISR_LOGWARN1(F("timer_set_alarm_value ="), TIMER_SCALE / frequency);
+        TISR_LOGWARN1(F("timer_set_alarm_value ="), (uint32_t) _timerCount);
 #elif USING_ESP32_S3_TIMERINTERRUPT
         // ESP32-S3 is embedded with four 54-bit general-purpose timers, which are based on 16-bit prescalers
         // and 54-bit auto-reload-capable up/down-timers
-        TISR_LOGWARN3(F("ESP32_S3_TimerInterrupt: _timerNo ="), _timerNo, F(", _fre ="), TIMER_BASE_CLK / TIMER_DIVIDER);
-        TISR_LOGWARN3(F("TIMER_BASE_CLK ="), TIMER_BASE_CLK, F(", TIMER_DIVIDER ="), TIMER_DIVIDER);
+        TISR_LOGWARN3(F("ESP32_S3_TimerInterrupt: _timerNo ="), _timerNo, F(", _fre ="), TIMER_BASE_CLK / divider);
+        TISR_LOGWARN3(F("TIMER_BASE_CLK ="), TIMER_BASE_CLK, F(", divider ="), divider);
         TISR_LOGWARN3(F("_timerIndex ="), _timerIndex, F(", _timerGroup ="), _timerGroup);
         TISR_LOGWARN3(F("_count ="), (uint32_t) (_timerCount >> 32) , F("-"), (uint32_t) (_timerCount));
-        TISR_LOGWARN1(F("timer_set_alarm_value ="), TIMER_SCALE / frequency);        
+        TISR_LOGWARN1(F("timer_set_alarm_value ="), (uint32_t) _timerCount);        
 #else
-        TISR_LOGWARN3(F("ESP32_TimerInterrupt: _timerNo ="), _timerNo, F(", _fre ="), TIMER_BASE_CLK / TIMER_DIVIDER);
-        TISR_LOGWARN3(F("TIMER_BASE_CLK ="), TIMER_BASE_CLK, F(", TIMER_DIVIDER ="), TIMER_DIVIDER);
+        TISR_LOGWARN3(F("ESP32_TimerInterrupt: _timerNo ="), _timerNo, F(", _fre ="), TIMER_BASE_CLK / divider);
+        TISR_LOGWARN3(F("TIMER_BASE_CLK ="), TIMER_BASE_CLK, F(", divider ="), divider);
         TISR_LOGWARN3(F("_timerIndex ="), _timerIndex, F(", _timerGroup ="), _timerGroup);
         TISR_LOGWARN3(F("_count ="), (uint32_t) (_timerCount >> 32) , F("-"), (uint32_t) (_timerCount));
-        TISR_LOGWARN1(F("timer_set_alarm_value ="), TIMER_SCALE / frequency);
+        TISR_LOGWARN1(F("timer_set_alarm_value ="), (uint32_t) _timerCount);
 #endif
 
-        timer_init(_timerGroup, _timerIndex, &stdConfig);
+        timer_config_t config = stdConfig;
+
+        config.divider = divider;
+
+        timer_init(_timerGroup, _timerIndex, &config);
         
         // Counter value to 0 => counting up to alarm value as .counter_dir == TIMER_COUNT_UP
         timer_set_counter_value(_timerGroup, _timerIndex , 0x00000000ULL);       
         
-        timer_set_alarm_value(_timerGroup, _timerIndex, TIMER_SCALE / frequency);
+        timer_set_alarm_value(_timerGroup, _timerIndex, _timerCount);
                
         // enable interrupts for _timerGroup, _timerIndex
         timer_enable_intr(_timerGroup, _timerIndex);
@@ -386,7 +689,11 @@ class ESP32TimerInterrupt
         // If the intr_alloc_flags value ESP_INTR_FLAG_IRAM is set, the handler function must be declared with IRAM_ATTR attribute
         // and can only call functions in IRAM or ROM. It cannot call other timer APIs.
        //timer_isr_register(_timerGroup, _timerIndex, _callback, (void *) (uint32_t) _timerNo, ESP_INTR_FLAG_IRAM, NULL);
-        timer_isr_callback_add(_timerGroup, _timerIndex, _callback, (void *) (uint32_t) _timerNo, 0);
+        if (isrCallbackAdd(periodicHandler, (void *) this) != ESP_OK)
+        {
+          // e.g. no free interrupt at _intrLevel on that core
+          return false;
+        }
 
         timer_start(_timerGroup, _timerIndex);
   
@@ -404,11 +711,202 @@ class ESP32TimerInterrupt
       }
     }
 
+    // Interrupt every q + r / 1e9 TIMER_BASE_CLK cycles, rounded to the nearest tick of the divider
+    bool setPeriodCycles(const uint64_t& q, const uint32_t& r, const esp32_timer_callback& callback)
+    {
+      uint32_t divider = (_divider == TIMER_DIVIDER_AUTO) ? bestDivider(q, r) : _divider;
+
+      return startPeriodic(divider, nearestCount(q, r, divider), q, r, callback);
+    }
+
+    // Counter clock divider for the next setPeriodXXX() / setFrequency() / attachInterruptXXX() : TIMER_DIVIDER (default,
+    // 1 / TIMER_SCALE s ticks), any fixed one in TIMER_DIVIDER_MIN-TIMER_DIVIDER_MAX, or TIMER_DIVIDER_AUTO choosing
+    // per period the smallest one programming it with the least error. Searching it takes up to a few ms for an odd
+    // number of TIMER_BASE_CLK cycles. Free-running mode always uses TIMER_DIVIDER
+    bool setDivider(const uint32_t& divider)
+    {
+      if ( (divider != TIMER_DIVIDER_AUTO) && ( (divider < TIMER_DIVIDER_MIN) || (divider > TIMER_DIVIDER_MAX) ) )
+      {
+        TISR_LOGERROR1(F("Error. Divider must be 2-65536, not"), divider);
+
+        return false;
+      }
+
+      _divider = divider;
+
+      return true;
+    }
+
+    // Divider in use by the counter, chosen by the last setPeriodXXX() / setFrequency() / attachInterruptXXX()
+    uint32_t getDivider() __attribute__((always_inline))
+    {
+      return _counterDivider;
+    };
+
+    // Period of exactly 'ticks' counter ticks, without any floating point rounding. Ticks are 1 / TIMER_SCALE s with the
+    // default divider, or with TIMER_DIVIDER_AUTO, and TIMER_BASE_CLK / divider with another fixed one.
+    // Returns false for a zero period
+    bool setPeriodTicks(const uint64_t& ticks, const esp32_timer_callback& callback)
+    {
+      return setPeriodCycles(ticks * ( (_divider == TIMER_DIVIDER_AUTO) ? TIMER_DIVIDER : _divider), 0, callback);
+    }
+
+    // Period of 'ns' nanoseconds, rounded to the nearest counter tick. getPeriodNs() returns the exact period achieved
+    bool setPeriodNs(const uint64_t& ns, const esp32_timer_callback& callback)
+    {
+      uint64_t subSecond = (ns % 1000000000ULL) * TIMER_BASE_CLK;
+
+      return setPeriodCycles( (ns / 1000000000ULL) * TIMER_BASE_CLK + subSecond / 1000000000ULL,
+                              (uint32_t) (subSecond % 1000000000ULL), callback);
+    }
+
+    // frequency (in hertz) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
+    // No params and duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
+    bool setFrequency(const float& frequency, const esp32_timer_callback& callback)
+    {
+      if ( !(frequency > 0) )
+      {
+        return startPeriodic(_counterDivider, 0, 0, 0, callback);
+      }
+
+      double    cycles  = (double) TIMER_BASE_CLK / frequency;
+      uint64_t  q       = (uint64_t) cycles;
+      uint32_t  r       = (uint32_t) ( (cycles - q) * 1e9);
+
+      if (_divider == TIMER_DIVIDER_AUTO)
+      {
+        return setPeriodCycles(q, r, callback);
+      }
+
+      // Fixed divider : truncated, as always
+      return startPeriodic(_divider, (uint64_t) ( (TIMER_BASE_CLK / _divider) / frequency), q, r, callback);
+    }
+
+    // Period programmed by the last setPeriodXXX() / setFrequency() / attachInterruptXXX(), in counter ticks of
+    // TIMER_BASE_CLK / getDivider(). 0 in free-running mode
+    uint64_t getPeriodTicks() __attribute__((always_inline))
+    {
+      return _timerCount;
+    };
+
+    // Same, in nanoseconds, rounded to the nearest one
+    uint64_t getPeriodNs()
+    {
+      uint64_t cycles = _timerCount * _counterDivider;
+
+      return (cycles / TIMER_BASE_CLK) * 1000000000ULL + ( (cycles % TIMER_BASE_CLK) * 1000000000ULL + TIMER_BASE_CLK / 2) /
+             TIMER_BASE_CLK;
+    };
+
+    // (programmed - requested) / requested period of the last setPeriodXXX() / setFrequency() / attachInterruptXXX() /
+    // updatePeriodXXX(), e.g. 1e-6 for a period 1ppm too long. Float math, so not from an ISR
+    float getPeriodError()
+    {
+      // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+      portENTER_CRITICAL(&_alarmMux);
+
+      uint64_t count    = _requestedCount;
+      uint32_t divider  = _counterDivider;
+      uint64_t q        = _requestedQ;
+      uint32_t r        = _requestedR;
+
+      // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+      portEXIT_CRITICAL(&_alarmMux);
+
+      return ( (q > 0) || (r > 0) ) ? periodError(count, divider, q, r) : 0;
+    };
+
+    // Change the period of the running periodic timer, keeping the divider, in ticks of TIMER_BASE_CLK / getDivider().
+    // Only the alarm value is rewritten, at the next period boundary, so that the current period keeps its length and the
+    // phase doesn't jump. Callable from task and ISR, including this timer's own callback, the period starting at the
+    // interrupt then being the new one. Returns false for a period under TIMER_MIN_ALARM_CYCLES, or if not in a periodic
+    // mode
+    bool IRAM_ATTR updatePeriodTicks(const uint64_t& ticks)
+    {
+      return updatePeriodCount(ticks, ticks * _counterDivider, 0);
+    }
+
+    // Same, interval in microseconds, rounded to the nearest tick
+    bool IRAM_ATTR updatePeriod(const unsigned long& interval)
+    {
+      uint64_t q      = (uint64_t) interval * (TIMER_BASE_CLK / 1000000);
+      uint64_t count  = nearestCount(q, 0, _counterDivider);
+
+      return updatePeriodCount(count, q, 0);
+    }
+
+    // Same, in nanoseconds, rounded to the nearest tick
+    bool IRAM_ATTR updatePeriodNs(const uint64_t& ns)
+    {
+      uint64_t subSecond  = (ns % 1000000000ULL) * TIMER_BASE_CLK;
+      uint64_t q          = (ns / 1000000000ULL) * TIMER_BASE_CLK + subSecond / 1000000000ULL;
+      uint32_t r          = (uint32_t) (subSecond % 1000000000ULL);
+      uint64_t count      = nearestCount(q, r, _counterDivider);
+
+      return updatePeriodCount(count, q, r);
+    }
+
+    // Select the core servicing the interrupt of this timer, for the next setFrequency() / attachInterruptXXX().
+    // The callback then runs on that core. tskNO_AFFINITY (default) is the core calling them, i.e. the one running
+    // setup(). Returns false for a core the chip doesn't have
+    bool setInterruptCore(const BaseType_t& core)
+    {
+      if ( (core != tskNO_AFFINITY) && ( (core < 0) || (core >= portNUM_PROCESSORS) ) )
+      {
+        TISR_LOGERROR1(F("Error. No such core"), core);
+
+        return false;
+      }
+
+      _core = core;
+
+      return true;
+    }
+
+    BaseType_t getInterruptCore() __attribute__((always_inline))
+    {
+      return _core;
+    };
+
+    // Select the interrupt level, 1-3 or TIMER_INTR_LEVEL_DEFAULT, for the next setFrequency() / attachInterruptXXX().
+    // A higher level preempts the lower ones, e.g. WiFi / BT and most drivers at level 1.
+    // Returns false for a level above TIMER_INTR_LEVEL_MAX
+    bool setInterruptLevel(const uint8_t& level)
+    {
+      if (level > TIMER_INTR_LEVEL_MAX)
+      {
+        TISR_LOGERROR1(F("Error. Interrupt level must be 0-"), TIMER_INTR_LEVEL_MAX);
+
+        return false;
+      }
+
+      _intrLevel = level;
+
+      return true;
+    }
+
+    uint8_t getInterruptLevel() __attribute__((always_inline))
+    {
+      return _intrLevel;
+    };
+
+    // Keep the interrupt enabled while the flash cache is disabled, for the next setFrequency() / attachInterruptXXX().
+    // The callback must then be IRAM_ATTR, and they fail otherwise
+    void setInterruptIRAM(const bool& intrIRAM)
+    {
+      _intrIRAM = intrIRAM;
+    }
+
+    bool getInterruptIRAM() __attribute__((always_inline))
+    {
+      return _intrIRAM;
+    };
+
     // interval (in microseconds) and duration (in milliseconds). Duration = 0 or not specified => run indefinitely
     // No params and duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
     bool setInterval(const unsigned long& interval, const esp32_timer_callback& callback)
     {
-      return setFrequency((float) (1000000.0f / interval), callback);
+      return setPeriodCycles( (uint64_t) interval * (TIMER_BASE_CLK / 1000000), 0, callback);
     }
 
     bool attachInterrupt(const float& frequency, const esp32_timer_callback& callback)
@@ -420,7 +918,191 @@ class ESP32TimerInterrupt
     // No params and duration now. To be addes in the future by adding similar functions here or to esp32-hal-timer.c
     bool attachInterruptInterval(const unsigned long& interval, const esp32_timer_callback& callback)
     {
-      return setFrequency( (float) ( 1000000.0f / interval), callback);
+      return setPeriodCycles( (uint64_t) interval * (TIMER_BASE_CLK / 1000000), 0, callback);
+    }
+
+    // Free-running mode. The counter counts up from 0 at TIMER_SCALE Hz, is never reloaded, and the interrupt is only
+    // raised at the alarm programmed by setAlarmAfter(). 'arg' is passed to the callback.
+    // Used by ESP32_ISR_Timer::attachTicklessTimer()
+    bool attachInterruptFreeRunning(const esp32_timer_callback& callback, void* arg)
+    {
+      if (_timerNo < MAX_ESP32_NUM_TIMERS)
+      {
+        if (!checkCallback(callback))
+        {
+          return false;
+        }
+
+        timer_config_t config = stdConfig;
+
+        config.alarm_en     = TIMER_ALARM_DIS;
+        config.auto_reload  = TIMER_AUTORELOAD_DIS;
+
+        _frequency      = TIMER_SCALE;
+        _counterDivider = TIMER_DIVIDER;
+        _timerCount     = 0;
+
+        setRequested(0, 0, 0);
+
+        TISR_LOGWARN3(F("ESP32_TimerInterrupt: free-running _timerNo ="), _timerNo, F(", _fre ="), TIMER_SCALE);
+
+        timer_init(_timerGroup, _timerIndex, &config);
+
+        timer_set_counter_value(_timerGroup, _timerIndex , 0x00000000ULL);
+
+        timer_enable_intr(_timerGroup, _timerIndex);
+
+        _callback = callback;
+
+        if (isrCallbackAdd(callback, arg) != ESP_OK)
+        {
+          return false;
+        }
+
+        timer_start(_timerGroup, _timerIndex);
+
+        return true;
+      }
+      else
+      {
+#if USING_ESP32_C3_TIMERINTERRUPT
+        TISR_LOGERROR(F("Error. Timer must be 0-1"));
+#else
+        TISR_LOGERROR(F("Error. Timer must be 0-3"));
+#endif
+
+        return false;
+      }
+    }
+
+    // Counter only, without interrupt : counts up from 0 at TIMER_SCALE Hz and is never reloaded. A time base for
+    // getCounter(), e.g. for ESP32TimerCapture
+    bool startCounter()
+    {
+      if (_timerNo < MAX_ESP32_NUM_TIMERS)
+      {
+        timer_config_t config = stdConfig;
+
+        config.alarm_en     = TIMER_ALARM_DIS;
+        config.auto_reload  = TIMER_AUTORELOAD_DIS;
+
+        _frequency      = TIMER_SCALE;
+        _counterDivider = TIMER_DIVIDER;
+        _timerCount     = 0;
+
+        setRequested(0, 0, 0);
+
+        timer_init(_timerGroup, _timerIndex, &config);
+
+        timer_set_counter_value(_timerGroup, _timerIndex , 0x00000000ULL);
+
+        timer_start(_timerGroup, _timerIndex);
+
+        return true;
+      }
+      else
+      {
+#if USING_ESP32_C3_TIMERINTERRUPT
+        TISR_LOGERROR(F("Error. Timer must be 0-1"));
+#else
+        TISR_LOGERROR(F("Error. Timer must be 0-3"));
+#endif
+
+        return false;
+      }
+    }
+
+    // One-shot mode : free-running mode, the callback getting the timer number as the periodic modes. The interrupt is
+    // only raised at the counter values programmed by armAt() / armAfter(), once each
+    bool attachInterruptOneShot(const esp32_timer_callback& callback)
+    {
+      return attachInterruptFreeRunning(callback, (void *) (uintptr_t) _timerNo);
+    }
+
+    // Current counter value, in ticks of 1 / TIMER_SCALE s in free-running / one-shot mode. Callable from task and ISR
+    uint64_t IRAM_ATTR getCounter()
+    {
+      uint64_t counter;
+
+      if (xPortInIsrContext())
+      {
+        counter = timer_group_get_counter_value_in_isr(_timerGroup, _timerIndex);
+      }
+      else
+      {
+        timer_get_counter_value(_timerGroup, _timerIndex, &counter);
+      }
+
+      return counter;
+    }
+
+    // Raise the interrupt once, when the counter reaches 'ticks', in free-running / one-shot mode. Callable from task and
+    // ISR, including from this timer's own callback, to chain exact events without drift: armAt(getAlarm() + delta).
+    // A value less than TIMER_MIN_ALARM_CYCLES ahead of the counter is too late : the interrupt is then raised as soon
+    // as possible, and false returned
+    bool IRAM_ATTR armAt(const uint64_t& ticks)
+    {
+      enterAlarmCritical();
+
+      uint64_t  earliest  = getCounter() + minAlarmTicks();
+      bool      onTime    = (ticks >= earliest);
+      uint64_t  alarm     = onTime ? ticks : earliest;
+
+      if (xPortInIsrContext())
+      {
+        timer_group_set_alarm_value_in_isr(_timerGroup, _timerIndex, alarm);
+        timer_group_enable_alarm_in_isr(_timerGroup, _timerIndex);
+      }
+      else
+      {
+        timer_set_alarm_value(_timerGroup, _timerIndex, alarm);
+        timer_set_alarm(_timerGroup, _timerIndex, TIMER_ALARM_EN);
+      }
+
+      _alarmTicks = ticks;
+
+      exitAlarmCritical();
+
+      return onTime;
+    }
+
+    // Same, 'ticks' counter ticks from now
+    bool IRAM_ATTR armAfter(const uint64_t& ticks)
+    {
+      return armAt(getCounter() + ticks);
+    }
+
+    // Counter value requested by the last armAt() / armAfter(), even if late
+    uint64_t getAlarm() __attribute__((always_inline))
+    {
+      return _alarmTicks;
+    };
+
+    // Raise the interrupt once, 'ticks' counter ticks (1 / TIMER_SCALE s) from now. Callable from task and ISR,
+    // including from this timer's own callback. Interrupts are disabled from the counter read to the alarm write, so
+    // that nothing can delay the write past the new alarm value, and concurrent calls from both cores are serialized
+    void IRAM_ATTR setAlarmAfter(const uint64_t& ticks)
+    {
+      uint64_t counter;
+      uint64_t minTicks = minAlarmTicks();
+      uint64_t delta    = (ticks > minTicks) ? ticks : minTicks;
+
+      enterAlarmCritical();
+
+      if (xPortInIsrContext())
+      {
+        // The driver re-enables the alarm after the callback as the alarm value has changed
+        counter = timer_group_get_counter_value_in_isr(_timerGroup, _timerIndex);
+        timer_group_set_alarm_value_in_isr(_timerGroup, _timerIndex, counter + delta);
+      }
+      else
+      {
+        timer_get_counter_value(_timerGroup, _timerIndex, &counter);
+        timer_set_alarm_value(_timerGroup, _timerIndex, counter + delta);
+        timer_set_alarm(_timerGroup, _timerIndex, TIMER_ALARM_EN);
+      }
+
+      exitAlarmCritical();
     }
 
     void detachInterrupt()
@@ -487,6 +1169,8 @@ class ESP32TimerInterrupt
 }; // class ESP32TimerInterrupt
 
 #include "ESP32_ISR_Timer.hpp"
+#include "ESP32TimerCapture.hpp"
+#include "ESP32_ISR_StaticSchedule.hpp"
 
 #endif    // ESP32TIMERINTERRUPT_HPP
 
@@ -0,0 +1,1058 @@
+/****************************************************************************************************************************
+  ESP32TimerInterrupt_HostSim.h
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.2+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32TimerInterrupt
+  Licensed under MIT license
+
+  Host (Linux / macOS) simulation of the parts of Arduino, ESP-IDF and FreeRTOS used by this library :
+  timer-group driver, esp_timer, critical sections, IRAM_ATTR, task notifications and a virtual clock.
+
+  It's only used when compiling for the host with ESP32_TIMER_INTERRUPT_HOST_SIM defined, for example
+
+    g++ -std=gnu++11 -DESP32_TIMER_INTERRUPT_HOST_SIM -I<path to library>/src my_test.cpp -lpthread
+
+  Time only moves when told to, by ESP32Sim::advanceUs() or delay(). Hardware timer alarms falling inside the
+  advanced time fire in order, at their exact counter value, and call the registered ISR callbacks synchronously
+  from the caller's thread, in ISR context (xPortInIsrContext() is true). ESP.getCycleCount() is the exception,
+  counting real host time, to benchmark the library code.
+
+  Tasks created by xTaskCreatePinnedToCore() run in their own thread, and may use the library meanwhile. All other
+  threads are the Arduino loop task for xTaskGetCurrentTaskHandle().
+
+  GPIO interrupts handlers, attached by attachInterrupt(), are only called by ESP32Sim::gpioInterrupt().
+
+  Simulated chip : ESP32, 2 timer groups of 2 timers, APB clock 80MHz, counters counting up only.
+  By default, as on ESP32_S2/S3/C3, an alarm set to a value already passed fires at once. With CONFIG_IDF_TARGET_ESP32
+  defined, as on the classic ESP32, whose alarm only matches while the counter equals it, such an alarm never fires,
+  the 64-bit counter wrapping first.
+
+  Define ESP32_TIMER_INTERRUPT_HOST_SIM_MAIN to the number of virtual milliseconds to run an Arduino sketch for.
+  main() then calls setup() once, then loop() repeatedly, advancing the virtual clock by 1ms per loop().
+
+  Version: 2.3.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  2.3.0   K Hoang      16/11/2022 Fix doubled time for ESP32_C3, ESP32_S2 and ESP32_S3
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef ESP32TIMERINTERRUPT_HOSTSIM_H
+#define ESP32TIMERINTERRUPT_HOSTSIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <vector>
+
+/////////////////////////////////////////////////////////
+// Arduino
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+#define F(x)                (x)
+
+#define ARDUINO_BOARD       "ESP32_HOST_SIM"
+
+#ifndef F_CPU
+  #define F_CPU             240000000L
+#endif
+
+#define LOW                 0x0
+#define HIGH                0x1
+
+#define INPUT               0x01
+#define OUTPUT              0x03
+#define INPUT_PULLUP        0x05
+
+/////////////////////////////////////////////////////////
+// ESP-IDF
+
+typedef int esp_err_t;
+
+#define ESP_OK              0
+#define ESP_FAIL            -1
+#define ESP_ERR_INVALID_ARG 0x102
+
+// APB_CLK_FREQ
+#define TIMER_BASE_CLK      80000000
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+#define ESP_INTR_FLAG_LEVEL1    (1 << 1)
+#define ESP_INTR_FLAG_LEVEL2    (1 << 2)
+#define ESP_INTR_FLAG_LEVEL3    (1 << 3)
+#define ESP_INTR_FLAG_LOWMED    (ESP_INTR_FLAG_LEVEL1 | ESP_INTR_FLAG_LEVEL2 | ESP_INTR_FLAG_LEVEL3)
+#define ESP_INTR_FLAG_IRAM      (1 << 10)
+
+typedef enum
+{
+  TIMER_GROUP_0 = 0,
+  TIMER_GROUP_1 = 1,
+  TIMER_GROUP_MAX,
+} timer_group_t;
+
+typedef enum
+{
+  TIMER_0 = 0,
+  TIMER_1 = 1,
+  TIMER_MAX,
+} timer_idx_t;
+
+typedef enum
+{
+  TIMER_COUNT_DOWN = 0,
+  TIMER_COUNT_UP = 1,
+  TIMER_COUNT_MAX
+} timer_count_dir_t;
+
+typedef enum
+{
+  TIMER_PAUSE = 0,
+  TIMER_START = 1,
+} timer_start_t;
+
+typedef enum
+{
+  TIMER_ALARM_DIS = 0,
+  TIMER_ALARM_EN = 1,
+  TIMER_ALARM_MAX
+} timer_alarm_t;
+
+typedef enum
+{
+  TIMER_INTR_LEVEL = 0,
+  TIMER_INTR_MAX
+} timer_intr_mode_t;
+
+typedef enum
+{
+  TIMER_AUTORELOAD_DIS = 0,
+  TIMER_AUTORELOAD_EN = 1,
+  TIMER_AUTORELOAD_MAX,
+} timer_autoreload_t;
+
+typedef enum
+{
+  TIMER_INTR_T0 = (1 << 0),
+  TIMER_INTR_T1 = (1 << 1),
+  TIMER_INTR_WDT = (1 << 2),
+  TIMER_INTR_NONE = 0
+} timer_intr_t;
+
+typedef struct
+{
+  timer_alarm_t alarm_en;
+  timer_start_t counter_en;
+  timer_intr_mode_t intr_type;
+  timer_count_dir_t counter_dir;
+  timer_autoreload_t auto_reload;
+  uint32_t divider;
+} timer_config_t;
+
+typedef bool (*timer_isr_t)(void *);
+
+/////////////////////////////////////////////////////////
+// FreeRTOS
+
+typedef int             BaseType_t;
+typedef unsigned int    UBaseType_t;
+typedef uint32_t        TickType_t;
+
+#define pdFALSE                 0
+#define pdTRUE                  1
+#define pdFAIL                  0
+#define pdPASS                  1
+
+#define portMAX_DELAY           0xFFFFFFFFUL
+#define tskNO_AFFINITY          0x7FFFFFFF
+#define configMAX_PRIORITIES    25
+#define portNUM_PROCESSORS      2
+
+#define portYIELD_FROM_ISR()    do {} while (0)
+
+namespace ESP32Sim
+{
+  struct Task
+  {
+    void                    (*function)(void *);
+    void*                   arg;
+    uint32_t                notifications;
+    bool                    blocked;
+    std::condition_variable wakeUp;
+  };
+}
+
+typedef ESP32Sim::Task* TaskHandle_t;
+
+// Recursive like the ESP32 spinlock taken twice by the same core
+struct portMUX_TYPE
+{
+  std::recursive_mutex mutex;
+
+  portMUX_TYPE(int = 0) {}
+  portMUX_TYPE(const portMUX_TYPE&) {}
+  portMUX_TYPE& operator=(const portMUX_TYPE&)
+  {
+    return *this;
+  }
+};
+
+#define portMUX_INITIALIZER_UNLOCKED    0
+
+#define portENTER_CRITICAL(mux)         (mux)->mutex.lock()
+#define portEXIT_CRITICAL(mux)          (mux)->mutex.unlock()
+#define portENTER_CRITICAL_ISR(mux)     (mux)->mutex.lock()
+#define portEXIT_CRITICAL_ISR(mux)      (mux)->mutex.unlock()
+
+/////////////////////////////////////////////////////////
+// Virtual clock and simulated timer groups
+
+namespace ESP32Sim
+{
+  // APB clock cycles per microsecond
+  const uint64_t CYCLES_PER_US = TIMER_BASE_CLK / 1000000;
+
+  struct Timer
+  {
+    bool          running;
+    uint32_t      divider;
+    bool          autoReload;
+    bool          alarmEnabled;
+    bool          intrEnabled;
+    uint64_t      alarm;
+    uint64_t      reload;           // value loaded on auto-reload, last one written by timer_set_counter_value()
+    uint64_t      counter;          // counter value at syncCycle
+    uint64_t      syncCycle;
+    timer_isr_t   callback;
+    void*         arg;
+    uint32_t      interrupts;       // number of ISR callbacks called
+    BaseType_t    core;             // core the interrupt is allocated on, by timer_isr_callback_add()
+    int           intrFlags;        // ESP_INTR_FLAG_XXX given to timer_isr_callback_add()
+  };
+
+  struct State
+  {
+    std::atomic<uint64_t> cycle;    // virtual time, in APB clock cycles
+    Timer         timers[TIMER_GROUP_MAX][TIMER_MAX];
+  };
+
+  // zero-initialized, as static
+  inline State& state()
+  {
+    static State simState;
+
+    return simState;
+  }
+
+  // Tasks can use the driver while the caller of advanceUs() runs the ISRs, so its state is guarded.
+  // Not held while an ISR callback runs, as on the chip
+  inline std::recursive_mutex& driverMutex()
+  {
+    static std::recursive_mutex mutex;
+
+    return mutex;
+  }
+
+  typedef std::lock_guard<std::recursive_mutex>   DriverLock;
+
+  // core running the thread. Core 1 for the Arduino loop task, the core an interrupt is allocated on for its ISR
+  inline BaseType_t& currentCore()
+  {
+    static thread_local BaseType_t core = 1;
+
+    return core;
+  }
+
+  // true in the thread running an ISR callback
+  inline bool& inIsr()
+  {
+    static thread_local bool isr = false;
+
+    return isr;
+  }
+
+  inline Timer& timer(const timer_group_t& group, const timer_idx_t& idx)
+  {
+    return state().timers[group][idx];
+  }
+
+  // Fold the elapsed time into t.counter, keeping the fraction of a counter tick in syncCycle
+  inline void sync(Timer& t)
+  {
+    uint64_t now = state().cycle;
+
+    if (t.running && (t.divider > 0))
+    {
+      uint64_t ticks = (now - t.syncCycle) / t.divider;
+
+      t.counter   += ticks;
+      t.syncCycle += ticks * t.divider;
+    }
+    else
+    {
+      t.syncCycle = now;
+    }
+  }
+
+  // Cycle at which the timer alarm fires, or false if it never will as things are
+  inline bool alarmCycle(Timer& t, uint64_t& cycle)
+  {
+    if (!t.running || !t.alarmEnabled || (t.divider == 0))
+      return false;
+
+    sync(t);
+
+#if defined(CONFIG_IDF_TARGET_ESP32)
+    // the classic ESP32 alarm only fires while the counter equals it, so a passed one waits for the counter to wrap
+    if (t.alarm < t.counter)
+      return false;
+#endif
+
+    cycle = (t.alarm > t.counter) ? t.syncCycle + (t.alarm - t.counter) * t.divider : state().cycle.load();
+
+    return true;
+  }
+
+  inline void fire(const timer_group_t& group, const timer_idx_t& idx, std::unique_lock<std::recursive_mutex>& lock)
+  {
+    Timer& t = timer(group, idx);
+
+    sync(t);
+
+    // the hardware clears alarm_en on alarm, and reloads the counter if auto-reload
+    t.alarmEnabled = false;
+
+    if (t.autoReload)
+      t.counter = t.reload;
+
+    if (t.intrEnabled && t.callback)
+    {
+      uint64_t oldAlarm = t.alarm;
+
+      t.interrupts++;
+
+      lock.unlock();
+
+      BaseType_t core = currentCore();
+
+      currentCore() = t.core;
+      inIsr()       = true;
+
+      t.callback(t.arg);
+
+      inIsr()       = false;
+      currentCore() = core;
+
+      lock.lock();
+
+      // as the ESP-IDF v4.4 timer ISR : re-enable the alarm if auto-reload, or if the callback moved it
+      if (t.autoReload || (t.alarm != oldAlarm))
+        t.alarmEnabled = true;
+    }
+  }
+
+  // current virtual time
+  inline uint64_t nowUs()
+  {
+    return state().cycle / CYCLES_PER_US;
+  }
+
+  inline uint64_t nowCycles()
+  {
+    return state().cycle;
+  }
+
+  // Advance the virtual clock by 'us' microseconds, firing every alarm on the way, in time order
+  inline void advanceUs(const uint64_t& us)
+  {
+    std::unique_lock<std::recursive_mutex> lock(driverMutex());
+
+    uint64_t target = state().cycle + us * CYCLES_PER_US;
+
+    while (true)
+    {
+      int       group = -1;
+      int       idx   = -1;
+      uint64_t  first = target;
+
+      for (int g = 0; g < TIMER_GROUP_MAX; g++)
+      {
+        for (int i = 0; i < TIMER_MAX; i++)
+        {
+          uint64_t cycle;
+
+          if (alarmCycle(state().timers[g][i], cycle) && (cycle <= first))
+          {
+            if ( (group < 0) || (cycle < first) )
+            {
+              first = cycle;
+              group = g;
+              idx   = i;
+            }
+          }
+        }
+      }
+
+      if (group < 0)
+        break;
+
+      state().cycle = first;
+
+      fire((timer_group_t) group, (timer_idx_t) idx, lock);
+    }
+
+    state().cycle = target;
+  }
+
+  // number of ISR callbacks called for this hardware timer since the start
+  inline uint32_t interruptCount(const timer_group_t& group, const timer_idx_t& idx)
+  {
+    return timer(group, idx).interrupts;
+  }
+
+  // core servicing the interrupt of this hardware timer
+  inline BaseType_t interruptCore(const timer_group_t& group, const timer_idx_t& idx)
+  {
+    return timer(group, idx).core;
+  }
+
+  // ESP_INTR_FLAG_XXX the interrupt of this hardware timer is allocated with
+  inline int interruptFlags(const timer_group_t& group, const timer_idx_t& idx)
+  {
+    return timer(group, idx).intrFlags;
+  }
+
+  /////////////////////////////////////////////////////////
+  // GPIO interrupts, raised by gpioInterrupt() only
+
+  #define ESP32_SIM_NUM_GPIOS     49
+
+  inline void (*&gpioHandler(const uint8_t& pin))()
+  {
+    static void (*handlers[ESP32_SIM_NUM_GPIOS])();
+
+    return handlers[pin % ESP32_SIM_NUM_GPIOS];
+  }
+
+  // Call the handler attached to 'pin' by attachInterrupt(), in ISR context, as if on 'core'
+  inline void gpioInterrupt(const uint8_t& pin, const BaseType_t& core = 1)
+  {
+    void (*handler)() = gpioHandler(pin);
+
+    if (handler == NULL)
+      return;
+
+    BaseType_t prevCore = currentCore();
+
+    currentCore() = core;
+    inIsr()       = true;
+
+    handler();
+
+    inIsr()       = false;
+    currentCore() = prevCore;
+  }
+
+  /////////////////////////////////////////////////////////
+  // Tasks run in their own thread. They must block in ulTaskNotifyTake()
+
+  inline std::mutex& taskMutex()
+  {
+    static std::mutex mutex;
+
+    return mutex;
+  }
+
+  inline std::condition_variable& taskIdle()
+  {
+    static std::condition_variable idle;
+
+    return idle;
+  }
+
+  inline std::vector<Task*>& tasks()
+  {
+    static std::vector<Task*> allTasks;
+
+    return allTasks;
+  }
+
+  inline Task*& currentTask()
+  {
+    static thread_local Task* current = NULL;
+
+    return current;
+  }
+
+  // Task handle of all the threads not created by xTaskCreatePinnedToCore(), as the Arduino loop task
+  inline Task* loopTask()
+  {
+    static Task task;
+
+    return &task;
+  }
+
+  // Wait until all tasks are blocked in ulTaskNotifyTake() with nothing pending, to keep tests deterministic
+  inline void waitTasksIdle()
+  {
+    std::unique_lock<std::mutex> lock(taskMutex());
+
+    taskIdle().wait(lock, []
+    {
+      for (Task* task : tasks())
+      {
+        if (!task->blocked || (task->notifications > 0))
+          return false;
+      }
+
+      return true;
+    });
+  }
+} // namespace ESP32Sim
+
+/////////////////////////////////////////////////////////
+// Arduino stand-ins
+
+inline unsigned long millis()
+{
+  return (unsigned long) (ESP32Sim::nowUs() / 1000);
+}
+
+inline unsigned long micros()
+{
+  return (unsigned long) ESP32Sim::nowUs();
+}
+
+inline void delay(const uint32_t& ms)
+{
+  ESP32Sim::advanceUs( (uint64_t) ms * 1000);
+}
+
+inline void delayMicroseconds(const uint32_t& us)
+{
+  ESP32Sim::advanceUs(us);
+}
+
+inline void yield() {}
+
+inline void pinMode(const uint8_t&, const uint8_t&) {}
+
+inline void digitalWrite(const uint8_t&, const uint8_t&) {}
+
+inline int digitalRead(const uint8_t&)
+{
+  return LOW;
+}
+
+#define RISING              0x01
+#define FALLING             0x02
+#define CHANGE              0x03
+
+inline uint8_t digitalPinToInterrupt(const uint8_t& pin)
+{
+  return pin;
+}
+
+inline void attachInterrupt(const uint8_t& pin, void (*handler)(), const int&)
+{
+  ESP32Sim::gpioHandler(pin) = handler;
+}
+
+inline void detachInterrupt(const uint8_t& pin)
+{
+  ESP32Sim::gpioHandler(pin) = NULL;
+}
+
+class HostSimSerial
+{
+  public:
+    void begin(const unsigned long&) {}
+
+    explicit operator bool() const
+    {
+      return true;
+    }
+
+    template<typename T>
+    void print(const T& value)
+    {
+      std::cout << value;
+    }
+
+    // As Arduino Print : uint8_t / int8_t are numbers, float / double with 2 decimals
+    void print(const uint8_t& value)
+    {
+      std::cout << (unsigned) value;
+    }
+
+    void print(const int8_t& value)
+    {
+      std::cout << (int) value;
+    }
+
+    void print(const double& value)
+    {
+      std::ios::fmtflags flags = std::cout.flags();
+
+      std::cout << std::fixed << std::setprecision(2) << value;
+      std::cout.flags(flags);
+    }
+
+    void print(const float& value)
+    {
+      print( (double) value);
+    }
+
+    template<typename T>
+    void println(const T& value)
+    {
+      print(value);
+      std::cout << std::endl;
+    }
+
+    void println()
+    {
+      std::cout << std::endl;
+    }
+
+    template<typename... Args>
+    int printf(const char* format, Args... args)
+    {
+      int len = ::printf(format, args...);
+
+      fflush(stdout);
+
+      return len;
+    }
+
+    void flush()
+    {
+      std::cout.flush();
+    }
+};
+
+static HostSimSerial Serial;
+
+// ESP.getCycleCount() counts host wall-clock time, in cycles of a F_CPU clock, to benchmark the library code
+class HostSimEsp
+{
+  public:
+    uint32_t getCycleCount()
+    {
+      uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>
+                    (std::chrono::steady_clock::now().time_since_epoch()).count();
+
+      return (uint32_t) (ns * (F_CPU / 1000000) / 1000);
+    }
+
+    uint32_t getCpuFreqMHz()
+    {
+      return F_CPU / 1000000;
+    }
+};
+
+// Only used by the benchmarks, so unused in most translation units
+static HostSimEsp ESP __attribute__((unused));
+
+/////////////////////////////////////////////////////////
+// esp_timer, heap_caps
+
+inline int64_t esp_timer_get_time()
+{
+  return (int64_t) ESP32Sim::nowUs();
+}
+
+inline void* heap_caps_malloc(size_t size, uint32_t)
+{
+  return malloc(size);
+}
+
+inline void heap_caps_free(void* ptr)
+{
+  free(ptr);
+}
+
+/////////////////////////////////////////////////////////
+// FreeRTOS stand-ins
+
+inline BaseType_t xPortInIsrContext()
+{
+  return ESP32Sim::inIsr();
+}
+
+inline BaseType_t xPortGetCoreID()
+{
+  return ESP32Sim::currentCore();
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(void (*function)(void *), const char*, const uint32_t&, void* arg,
+                                          UBaseType_t, TaskHandle_t* handle, const BaseType_t& core)
+{
+  ESP32Sim::Task* task = new ESP32Sim::Task();
+
+  task->function  = function;
+  task->arg       = arg;
+
+  {
+    std::lock_guard<std::mutex> lock(ESP32Sim::taskMutex());
+
+    ESP32Sim::tasks().push_back(task);
+  }
+
+  if (handle)
+    *handle = task;
+
+  BaseType_t taskCore = (core == tskNO_AFFINITY) ? 0 : core;
+
+  std::thread([task, taskCore]()
+  {
+    ESP32Sim::currentTask() = task;
+    ESP32Sim::currentCore() = taskCore;
+    task->function(task->arg);
+  }).detach();
+
+  return pdPASS;
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+  return ESP32Sim::currentTask() ? ESP32Sim::currentTask() : ESP32Sim::loopTask();
+}
+
+// Only portMAX_DELAY is supported
+inline uint32_t ulTaskNotifyTake(const BaseType_t& clearCountOnExit, const TickType_t&)
+{
+  ESP32Sim::Task* task = ESP32Sim::currentTask();
+
+  std::unique_lock<std::mutex> lock(ESP32Sim::taskMutex());
+
+  task->blocked = true;
+  ESP32Sim::taskIdle().notify_all();
+
+  task->wakeUp.wait(lock, [task]
+  {
+    return task->notifications > 0;
+  });
+
+  task->blocked = false;
+
+  uint32_t notifications = task->notifications;
+
+  task->notifications = clearCountOnExit ? 0 : notifications - 1;
+
+  return notifications;
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+  std::lock_guard<std::mutex> lock(ESP32Sim::taskMutex());
+
+  task->notifications++;
+  task->wakeUp.notify_one();
+
+  return pdPASS;
+}
+
+inline void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higherPriorityTaskWoken)
+{
+  xTaskNotifyGive(task);
+
+  if (higherPriorityTaskWoken)
+    *higherPriorityTaskWoken = pdTRUE;
+}
+
+/////////////////////////////////////////////////////////
+// soc_memory_layout
+
+// The host has no flash cache to disable, so any code may run from an IRAM-safe interrupt
+inline bool esp_ptr_in_iram(const void*)
+{
+  return true;
+}
+
+/////////////////////////////////////////////////////////
+// esp_ipc
+
+typedef void (*esp_ipc_func_t)(void* arg);
+
+// Runs 'func' in the caller's thread, as if on core 'cpu'
+inline esp_err_t esp_ipc_call_blocking(uint32_t cpu, esp_ipc_func_t func, void* arg)
+{
+  if (cpu >= portNUM_PROCESSORS)
+    return ESP_ERR_INVALID_ARG;
+
+  BaseType_t core = ESP32Sim::currentCore();
+
+  ESP32Sim::currentCore() = cpu;
+  func(arg);
+  ESP32Sim::currentCore() = core;
+
+  return ESP_OK;
+}
+
+/////////////////////////////////////////////////////////
+// Timer-group driver stand-ins
+
+inline esp_err_t timer_init(timer_group_t group, timer_idx_t idx, const timer_config_t* config)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::Timer& t = ESP32Sim::timer(group, idx);
+
+  if ( (config->divider < 2) || (config->divider > 65536) || (config->counter_dir != TIMER_COUNT_UP) )
+    return ESP_ERR_INVALID_ARG;
+
+  ESP32Sim::sync(t);
+
+  t.divider       = config->divider;
+  t.autoReload    = (config->auto_reload == TIMER_AUTORELOAD_EN);
+  t.alarmEnabled  = (config->alarm_en == TIMER_ALARM_EN);
+  t.running       = (config->counter_en == TIMER_START);
+  t.intrEnabled   = false;
+  t.syncCycle     = ESP32Sim::state().cycle;
+
+  return ESP_OK;
+}
+
+inline esp_err_t timer_deinit(timer_group_t group, timer_idx_t idx)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::timer(group, idx) = ESP32Sim::Timer();
+
+  return ESP_OK;
+}
+
+inline esp_err_t timer_start(timer_group_t group, timer_idx_t idx)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::Timer& t = ESP32Sim::timer(group, idx);
+
+  ESP32Sim::sync(t);
+  t.running = true;
+
+  return ESP_OK;
+}
+
+inline esp_err_t timer_pause(timer_group_t group, timer_idx_t idx)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::Timer& t = ESP32Sim::timer(group, idx);
+
+  ESP32Sim::sync(t);
+  t.running = false;
+
+  return ESP_OK;
+}
+
+inline esp_err_t timer_set_counter_value(timer_group_t group, timer_idx_t idx, uint64_t value)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::Timer& t = ESP32Sim::timer(group, idx);
+
+  t.counter   = value;
+  t.reload    = value;
+  t.syncCycle = ESP32Sim::state().cycle;
+
+  return ESP_OK;
+}
+
+inline esp_err_t timer_get_counter_value(timer_group_t group, timer_idx_t idx, uint64_t* value)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::Timer& t = ESP32Sim::timer(group, idx);
+
+  ESP32Sim::sync(t);
+  *value = t.counter;
+
+  return ESP_OK;
+}
+
+inline uint64_t timer_group_get_counter_value_in_isr(timer_group_t group, timer_idx_t idx)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  uint64_t value;
+
+  timer_get_counter_value(group, idx, &value);
+
+  return value;
+}
+
+inline esp_err_t timer_set_alarm_value(timer_group_t group, timer_idx_t idx, uint64_t value)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::timer(group, idx).alarm = value;
+
+  return ESP_OK;
+}
+
+inline esp_err_t timer_get_alarm_value(timer_group_t group, timer_idx_t idx, uint64_t* value)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  *value = ESP32Sim::timer(group, idx).alarm;
+
+  return ESP_OK;
+}
+
+inline void timer_group_set_alarm_value_in_isr(timer_group_t group, timer_idx_t idx, uint64_t value)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::timer(group, idx).alarm = value;
+}
+
+inline esp_err_t timer_set_alarm(timer_group_t group, timer_idx_t idx, timer_alarm_t alarm)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::timer(group, idx).alarmEnabled = (alarm == TIMER_ALARM_EN);
+
+  return ESP_OK;
+}
+
+inline void timer_group_enable_alarm_in_isr(timer_group_t group, timer_idx_t idx)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::timer(group, idx).alarmEnabled = true;
+}
+
+inline esp_err_t timer_set_auto_reload(timer_group_t group, timer_idx_t idx, timer_autoreload_t reload)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::timer(group, idx).autoReload = (reload == TIMER_AUTORELOAD_EN);
+
+  return ESP_OK;
+}
+
+inline esp_err_t timer_set_divider(timer_group_t group, timer_idx_t idx, uint32_t divider)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::Timer& t = ESP32Sim::timer(group, idx);
+
+  if ( (divider < 2) || (divider > 65536) )
+    return ESP_ERR_INVALID_ARG;
+
+  ESP32Sim::sync(t);
+  t.divider = divider;
+
+  return ESP_OK;
+}
+
+inline esp_err_t timer_enable_intr(timer_group_t group, timer_idx_t idx)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::timer(group, idx).intrEnabled = true;
+
+  return ESP_OK;
+}
+
+inline esp_err_t timer_disable_intr(timer_group_t group, timer_idx_t idx)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::timer(group, idx).intrEnabled = false;
+
+  return ESP_OK;
+}
+
+inline esp_err_t timer_group_intr_enable(timer_group_t group, timer_intr_t mask)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  for (int i = 0; i < TIMER_MAX; i++)
+  {
+    if (mask & (1 << i))
+      ESP32Sim::timer(group, (timer_idx_t) i).intrEnabled = true;
+  }
+
+  return ESP_OK;
+}
+
+inline esp_err_t timer_group_intr_disable(timer_group_t group, timer_intr_t mask)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  for (int i = 0; i < TIMER_MAX; i++)
+  {
+    if (mask & (1 << i))
+      ESP32Sim::timer(group, (timer_idx_t) i).intrEnabled = false;
+  }
+
+  return ESP_OK;
+}
+
+inline esp_err_t timer_isr_callback_add(timer_group_t group, timer_idx_t idx, timer_isr_t isr_handler, void* arg,
+                                        int intr_alloc_flags)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::Timer& t = ESP32Sim::timer(group, idx);
+
+  t.callback  = isr_handler;
+  t.arg       = arg;
+  t.core      = ESP32Sim::currentCore();
+  t.intrFlags = intr_alloc_flags;
+
+  return ESP_OK;
+}
+
+inline esp_err_t timer_isr_callback_remove(timer_group_t group, timer_idx_t idx)
+{
+  ESP32Sim::DriverLock lock(ESP32Sim::driverMutex());
+
+  ESP32Sim::timer(group, idx).callback = NULL;
+
+  return ESP_OK;
+}
+
+/////////////////////////////////////////////////////////
+// Sketch runner
+
+#if defined(ESP32_TIMER_INTERRUPT_HOST_SIM_MAIN)
+
+void setup();
+void loop();
+
+int main()
+{
+  setup();
+
+  while (millis() < (unsigned long) (ESP32_TIMER_INTERRUPT_HOST_SIM_MAIN))
+  {
+    loop();
+    ESP32Sim::advanceUs(1000);
+  }
+
+  return 0;
+}
+
+#endif
+
+#endif    // ESP32TIMERINTERRUPT_HOSTSIM_H
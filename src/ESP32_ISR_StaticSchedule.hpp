@@ -0,0 +1,199 @@
+/****************************************************************************************************************************
+  ESP32_ISR_StaticSchedule.hpp
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.2+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32TimerInterrupt
+  Licensed under MIT license
+
+  ISR-based timers fixed at compile time. The periods, callbacks and numbers of runs are template arguments, from
+  which the compiler generates a dispatch routine calling each callback directly, with the reload values of its
+  countdown as constants. No slot table, lookup, NULL check nor registration at runtime: only the countdowns are in RAM.
+
+  Version: 2.3.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  2.3.0   K Hoang      16/11/2022 Fix doubled time for ESP32_C3, ESP32_S2 and ESP32_S3
+*****************************************************************************************************************************/
+
+#pragma once
+
+#ifndef ESP32_ISR_STATICSCHEDULE_HPP
+#define ESP32_ISR_STATICSCHEDULE_HPP
+
+// One timer of an ESP32_ISR_StaticSchedule : call 'CALLBACK' every 'PERIOD_MS' milliseconds, 'NUM_RUNS' times,
+// TIMER_RUN_FOREVER (default) or TIMER_RUN_ONCE for example
+template<unsigned long PERIOD_MS, void (*CALLBACK)(), uint32_t NUM_RUNS = TIMER_RUN_FOREVER>
+struct ESP32StaticTimer
+{
+  static_assert(PERIOD_MS > 0, "ESP32StaticTimer period must be at least 1ms");
+  static_assert(CALLBACK != NULL, "ESP32StaticTimer callback must not be NULL");
+
+  static constexpr unsigned long period()
+  {
+    return PERIOD_MS;
+  };
+
+  static constexpr uint32_t numRuns()
+  {
+    return NUM_RUNS;
+  };
+
+  static void IRAM_ATTR call() __attribute__((always_inline))
+  {
+    CALLBACK();
+  };
+};
+
+// Dispatch code of the timers from INDEX on, run() being called every TICK_MS milliseconds. Each level handles one
+// timer, then the next one, all inlined into ESP32_ISR_StaticSchedule::run()
+template<unsigned long TICK_MS, size_t INDEX, typename... TIMERS>
+struct ESP32StaticDispatch
+{
+  static constexpr unsigned long tickMs(const unsigned long& ms)
+  {
+    return ms;
+  };
+
+  static void IRAM_ATTR reset(uint32_t*, uint32_t*) __attribute__((always_inline))
+  {
+  };
+
+  static void IRAM_ATTR run(uint32_t*, uint32_t*) __attribute__((always_inline))
+  {
+  };
+};
+
+template<unsigned long TICK_MS, size_t INDEX, typename TIMER, typename... REST>
+struct ESP32StaticDispatch<TICK_MS, INDEX, TIMER, REST...>
+{
+  typedef ESP32StaticDispatch<TICK_MS, INDEX + 1, REST...>  next_t;
+
+  // greatest common divisor of 'ms' and the periods of the timers from INDEX on
+  static constexpr unsigned long tickMs(const unsigned long& ms)
+  {
+    return next_t::tickMs(gcd(ms, TIMER::period()));
+  };
+
+  // number of run() per period
+  static constexpr uint32_t reload()
+  {
+    return TIMER::period() / TICK_MS;
+  };
+
+  static void IRAM_ATTR reset(uint32_t* countdown, uint32_t* runsLeft) __attribute__((always_inline))
+  {
+    countdown[INDEX] = reload();
+    runsLeft[INDEX]  = TIMER::numRuns();
+
+    next_t::reset(countdown, runsLeft);
+  };
+
+  // All the tests on reload() and numRuns() are resolved at compile time
+  static void IRAM_ATTR run(uint32_t* countdown, uint32_t* runsLeft) __attribute__((always_inline))
+  {
+    if ( (TIMER::numRuns() == TIMER_RUN_FOREVER) || (runsLeft[INDEX] > 0) )
+    {
+      // a timer with the period of the tick fires on every run(), without countdown
+      if ( (reload() == 1) || (--countdown[INDEX] == 0) )
+      {
+        if (reload() > 1)
+          countdown[INDEX] = reload();
+
+        if (TIMER::numRuns() != TIMER_RUN_FOREVER)
+          runsLeft[INDEX]--;
+
+        TIMER::call();
+      }
+    }
+
+    next_t::run(countdown, runsLeft);
+  };
+
+  static constexpr unsigned long gcd(const unsigned long& a, const unsigned long& b)
+  {
+    return (b == 0) ? a : gcd(b, a % b);
+  };
+};
+
+// ISR-based timers fixed at compile time, e.g.
+//
+//   ESP32_ISR_StaticSchedule< ESP32StaticTimer<1000, blink>,
+//                             ESP32StaticTimer<5000, report>,
+//                             ESP32StaticTimer<200,  beep, 3> >   Schedule;
+//
+// run() must be called every tickMs() milliseconds, the greatest common divisor of the periods, e.g. by the handler of
+// ITimer.attachInterruptInterval(Schedule.tickUs(), TimerHandler). The callbacks are called in the order of the list,
+// from run(), so must be IRAM_ATTR and as short as ESP32_ISR_Timer ones. As all timers are known, a given one is
+// referred to by its position in the list
+template<typename... TIMERS>
+class ESP32_ISR_StaticSchedule
+{
+    static_assert(sizeof...(TIMERS) > 0, "ESP32_ISR_StaticSchedule needs at least one timer");
+
+    // the tick is computed by a first instance, whose tick is unused
+    typedef ESP32StaticDispatch<0, 0, TIMERS...>                        gcd_t;
+    typedef ESP32StaticDispatch<gcd_t::tickMs(0), 0, TIMERS...>         dispatch_t;
+
+  public:
+
+    // time between two run(), in milliseconds
+    static constexpr unsigned long tickMs()
+    {
+      return gcd_t::tickMs(0);
+    };
+
+    // time between two run(), in microseconds, as attachInterruptInterval() takes
+    static constexpr uint64_t tickUs()
+    {
+      return (uint64_t) tickMs() * 1000;
+    };
+
+    static constexpr size_t getNumTimers()
+    {
+      return sizeof...(TIMERS);
+    };
+
+    ESP32_ISR_StaticSchedule() : restartPending(false)
+    {
+      dispatch_t::reset(countdown, runsLeft);
+    };
+
+    // this function must be called every tickMs(), from an ISR or a task
+    void IRAM_ATTR run()
+    {
+      if (__atomic_load_n(&restartPending, __ATOMIC_ACQUIRE))
+      {
+        __atomic_store_n(&restartPending, false, __ATOMIC_RELAXED);
+
+        dispatch_t::reset(countdown, runsLeft);
+      }
+
+      dispatch_t::run(countdown, runsLeft);
+    };
+
+    // Restart all the timers from the next run(), the ones with a number of runs doing them all again.
+    // Applied by run(), so can be called from any task or ISR, without lock on either side
+    void restart()
+    {
+      __atomic_store_n(&restartPending, true, __ATOMIC_RELEASE);
+    };
+
+    // returns the number of runs left of the timer at position 'index' in the list, 0 once done.
+    // Meaningless for TIMER_RUN_FOREVER ones
+    uint32_t getNumRunsLeft(const size_t& index)
+    {
+      return (index < sizeof...(TIMERS)) ? __atomic_load_n(&runsLeft[index], __ATOMIC_RELAXED) : 0;
+    };
+
+  private:
+
+    // Only accessed by run(), but for getNumRunsLeft(). Counting down the run() left to the next fire
+    uint32_t      countdown[sizeof...(TIMERS)];
+    uint32_t      runsLeft[sizeof...(TIMERS)];
+
+    volatile bool restartPending;
+};
+
+#endif    // ESP32_ISR_STATICSCHEDULE_HPP
@@ -58,119 +58,681 @@
 
 #include <string.h>
 
-ESP32_ISR_Timer::ESP32_ISR_Timer()
-  : numTimers (-1)
+template<size_t NUM_TIMERS>
+ESP32_ISR_TimerT<NUM_TIMERS>::ESP32_ISR_TimerT()
+  : numTimers (-1), heapSize (0), numSlackTimers (0), ticklessTimer (NULL), dispatchQueue (NULL),
+    dispatchOverruns (0), dispatchTask (NULL), runElapsed (1), dispatchElapsed (1)
 {
+  clearSlotMaps();
+
+#if (ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE > 0)
+  runTask     = NULL;
+
+  memset(generation, 0, sizeof (generation));
+#endif
 }
 
-void ESP32_ISR_Timer::init()
+template<size_t NUM_TIMERS>
+void ESP32_ISR_TimerT<NUM_TIMERS>::init()
 {
-  unsigned long current_millis = millis();   //elapsed();
+  esp32_isr_time_t current_time = now();
 
-  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  for (index_t i = 0; i < NUM_TIMERS; i++)
   {
-    memset((void*) &timer[i], 0, sizeof (timer_t));
-    timer[i].prev_millis = current_millis;
+    timer[i]    = timer_t();
+    flags[i]    = 0;
+    period[i]   = 0;
+    deadline[i] = current_time;
   }
 
-  numTimers = 0;
+  clearSlotMaps();
+
+  numTimers       = 0;
+  heapSize        = 0;
+  numSlackTimers  = 0;
+
+#if ESP32_ISR_TIMER_STATS
+  memset(stats, 0, sizeof (stats));
+#endif
 
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
   timerMux = portMUX_INITIALIZER_UNLOCKED;
 }
 
-void IRAM_ATTR ESP32_ISR_Timer::run()
+template<size_t NUM_TIMERS>
+void ESP32_ISR_TimerT<NUM_TIMERS>::clearSlotMaps()
 {
-  uint8_t i;
-  unsigned long current_millis;
+  // all slots free and disabled. Bits past NUM_TIMERS are never free
+  for (size_t w = 0; w < NUM_MAP_WORDS; w++)
+  {
+    freeMap[w]    = mapWordMask(w);
+    enabledMap[w] = 0;
+  }
+}
+
+template<size_t NUM_TIMERS>
+void IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::run()
+{
+  index_t i;
+  index_t numDue = 0;
+  index_t numFired = 0;
+  bool    dispatched = false;
+  esp32_isr_time_t current_time;
 
   // get current time
-  current_millis = millis();   //elapsed();
+  current_time = now();
 
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
   portENTER_CRITICAL_ISR(&timerMux);
 
-  for (i = 0; i < MAX_NUMBER_TIMERS; i++)
+#if (ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE > 0)
+  if (!xPortInIsrContext())
+    runTask = xTaskGetCurrentTaskHandle();
+
+  applyCommands(current_time);
+#endif
+
+  // The heap top is the earliest deadline. If it's not due yet, no other timer is, and we're done.
+  // Each due timer is re-keyed to its next deadline, which is always later than current_time,
+  // so every timer is processed at most once per run()
+  while ( (heapSize > 0) && (numDue < NUM_TIMERS) )
+  {
+    i = heap[0];
+
+    // is it time to process this timer ?
+    // see http://arduino.cc/forum/index.php/topic,124048.msg932592.html#msg932592
+    if ( (esp32_isr_stime_t) (current_time - deadline[i]) < 0 )
+    {
+      break;
+    }
+
+    uint8_t defCall = fireTimer(i, current_time);
+
+    // next deadline is later than the current one => only need to sift down from the top
+    heapSiftDown(0);
+
+    numFired++;
+
+    if (defCall != TIMER_DEFCALL_DONTRUN)
+    {
+      dueList[numDue++] = i;
+    }
+  }
+
+  // As a timer couldn't wait any longer, also fire the timers whose period boundary is passed, but whose slack
+  // would have let them wait. They're anywhere in the heap, so this is a scan, only done when something fired
+  if ( (numFired > 0) && (numSlackTimers > 0) )
   {
+    // collect first, as re-keying reorders heap[]. The unused end of dueList is large enough
+    index_t numEarly = 0;
 
-    timer[i].toBeCalled = TIMER_DEFCALL_DONTRUN;
+    for (count_t pos = 0; pos < heapSize; pos++)
+    {
+      i = heap[pos];
 
-    // no callback == no timer, i.e. jump over empty slots
-    if (timer[i].callback != NULL)
+      if ( (timer[i].slack > 0) && ( (esp32_isr_stime_t) (current_time - (deadline[i] - timer[i].slack)) >= 0 ) )
+      {
+        dueList[numDue + numEarly++] = i;
+      }
+    }
+
+    // dueList is compacted in place, as numDue never gets past the entry being read
+    for (index_t k = numDue, end = numDue + numEarly; k < end; k++)
     {
+      i = dueList[k];
+
+      uint8_t defCall = fireTimer(i, current_time);
 
-      // is it time to process this timer ?
-      // see http://arduino.cc/forum/index.php/topic,124048.msg932592.html#msg932592
+      heapUpdate(i);
 
-      if ((current_millis - timer[i].prev_millis) >= timer[i].delay)
+      if (defCall != TIMER_DEFCALL_DONTRUN)
       {
-        unsigned long skipTimes = (current_millis - timer[i].prev_millis) / timer[i].delay;
-
-        // update time
-        timer[i].prev_millis += timer[i].delay * skipTimes;
-
-        // check if the timer callback has to be executed
-        if (timer[i].enabled)
-        {
-
-          // "run forever" timers must always be executed
-          if (timer[i].maxNumRuns == TIMER_RUN_FOREVER)
-          {
-            timer[i].toBeCalled = TIMER_DEFCALL_RUNONLY;
-          }
-          // other timers get executed the specified number of times
-          else if (timer[i].numRuns < timer[i].maxNumRuns)
-          {
-            timer[i].toBeCalled = TIMER_DEFCALL_RUNONLY;
-            timer[i].numRuns++;
-
-            // after the last run, delete the timer
-            if (timer[i].numRuns >= timer[i].maxNumRuns)
-            {
-              timer[i].toBeCalled = TIMER_DEFCALL_RUNANDDEL;
-            }
-          }
-        }
+        dueList[numDue++] = i;
       }
     }
   }
 
-  for (i = 0; i < MAX_NUMBER_TIMERS; i++)
+  for (index_t j = 0; j < numDue; j++)
   {
-    if (timer[i].toBeCalled == TIMER_DEFCALL_DONTRUN)
+    i = dueList[j];
+
+    // the timer may have been deleted by a previous callback in this run()
+    uint8_t defCall = toBeCalled(i);
+
+    if (defCall == TIMER_DEFCALL_DONTRUN)
       continue;
 
-    if (timer[i].hasParam)
-      (*(timer_callback_p)timer[i].callback)(timer[i].param);
-    else
-      (*(timer_callback)timer[i].callback)();
+    // a TIMER_OVERRUN_BURST timer is called once per pending period, others once for all of them
+    uint32_t numCalls = 1;
+
+    runElapsed = timer[i].pending;
+
+    if (overrunPolicy(i) == TIMER_OVERRUN_BURST)
+    {
+      numCalls   = runElapsed;
+      runElapsed = 1;
+    }
 
-    if (timer[i].toBeCalled == TIMER_DEFCALL_RUNANDDEL)
+    // stop a burst if a callback deletes its own timer
+    for (uint32_t call = 0; (call < numCalls) && (toBeCalled(i) != TIMER_DEFCALL_DONTRUN); call++)
+    {
+      if ( (flags[i] & TIMER_FLAG_DEFERRED) && (dispatchQueue != NULL) )
+      {
+        // only the bookkeeping is done here, the callback runs later in the dispatch task
+        if (dispatchPush(i, runElapsed))
+          dispatched = true;
+        else
+          dispatchOverruns++;
+      }
+      else
+        timer[i].callback();
+    }
+
+    if (defCall == TIMER_DEFCALL_RUNANDDEL)
       deleteTimer(i);
   }
 
+  rearmTickless();
+
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
   portEXIT_CRITICAL_ISR(&timerMux);
 
+  if (dispatched)
+  {
+    if (xPortInIsrContext())
+    {
+      BaseType_t higherPriorityTaskWoken = pdFALSE;
+
+      vTaskNotifyGiveFromISR(dispatchTask, &higherPriorityTaskWoken);
+
+      if (higherPriorityTaskWoken)
+        portYIELD_FROM_ISR();
+    }
+    else
+    {
+      xTaskNotifyGive(dispatchTask);
+    }
+  }
+
+}
+
+// Account a fire of the specified timer at current_time, at or after its period boundary, and move its deadline
+// to the next one. Returns what run() must do with the callback. Must be called with timerMux held, the caller
+// then restoring heap order
+template<size_t NUM_TIMERS>
+uint8_t IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::fireTimer(const index_t i, const esp32_isr_time_t& current_time)
+{
+  // time since the period boundary. Less than one period, unless run() was called too late or the slack is
+  // larger than the period
+  esp32_isr_time_t late   = current_time - (deadline[i] - timer[i].slack);
+  esp32_isr_time_t missed = 0;
+
+  // update time
+  if (late < period[i])
+  {
+    deadline[i] += period[i];
+  }
+  else
+  {
+    // skip the missed periods, the only case needing a division
+    missed = late / period[i];
+    deadline[i] += period[i] * (missed + 1);
+  }
+
+  uint8_t defCall = TIMER_DEFCALL_DONTRUN;
+
+  // check if the timer callback has to be executed
+  if (isEnabledSlot(i))
+  {
+    // number of periods accounted for by this fire : always 1 in the usual case of no missed period
+    uint32_t periods = 1;
+
+    if (missed > 0)
+    {
+      uint8_t overrun = overrunPolicy(i);
+
+      if (overrun == TIMER_OVERRUN_COALESCE)
+      {
+        periods += (missed < UINT32_MAX - 1) ? (uint32_t) missed : UINT32_MAX - 1;
+      }
+      else if (overrun == TIMER_OVERRUN_BURST)
+      {
+        timer[i].backlog = ( (uint64_t) timer[i].backlog + missed < UINT32_MAX) ?
+                           timer[i].backlog + (uint32_t) missed : UINT32_MAX;
+      }
+    }
+
+    // make up part of the backlog, bounding the calls per run()
+    if (timer[i].backlog > 0)
+    {
+      uint32_t extra = (timer[i].backlog < ESP32_ISR_TIMER_BURST_MAX - 1) ? timer[i].backlog :
+                       ESP32_ISR_TIMER_BURST_MAX - 1;
+
+      periods          += extra;
+      timer[i].backlog -= extra;
+    }
+
+    // "run forever" timers must always be executed
+    if (timer[i].maxNumRuns == TIMER_RUN_FOREVER)
+    {
+      defCall = TIMER_DEFCALL_RUNONLY;
+    }
+    // other timers get executed the specified number of times
+    else if (timer[i].numRuns < timer[i].maxNumRuns)
+    {
+      defCall = TIMER_DEFCALL_RUNONLY;
+
+      if (periods > timer[i].maxNumRuns - timer[i].numRuns)
+        periods = timer[i].maxNumRuns - timer[i].numRuns;
+
+      timer[i].numRuns += periods;
+
+      // after the last run, delete the timer
+      if (timer[i].numRuns >= timer[i].maxNumRuns)
+      {
+        defCall = TIMER_DEFCALL_RUNANDDEL;
+      }
+    }
+
+    timer[i].pending = periods;
+  }
+
+  setToBeCalled(i, defCall);
+
+#if ESP32_ISR_TIMER_STATS
+  if (defCall != TIMER_DEFCALL_DONTRUN)
+  {
+    // lateness from the last period boundary passed
+    recordStats(i, late - period[i] * missed, missed);
+  }
+#endif
+
+  return defCall;
+}
+
+template<size_t NUM_TIMERS>
+bool IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::dispatchPush(const index_t& numTimer, const uint32_t& elapsed)
+{
+  dispatch_t entry;
+
+  entry.callback = timer[numTimer].callback;
+  entry.elapsed  = elapsed;
+
+  // to the dispatch task, possibly running on the other core
+  return dispatchQueue->push(entry);
+}
+
+template<size_t NUM_TIMERS>
+void ESP32_ISR_TimerT<NUM_TIMERS>::dispatchTaskLoop(void* arg)
+{
+  ESP32_ISR_TimerT<NUM_TIMERS>* isrTimer = (ESP32_ISR_TimerT<NUM_TIMERS>*) arg;
+
+  while (true)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    dispatch_t entry;
+
+    // the entry is freed before the callback, so that run() can reuse it as soon as possible
+    while (isrTimer->dispatchQueue->pop(entry))
+    {
+      isrTimer->dispatchElapsed = entry.elapsed;
+
+      entry.callback();
+    }
+  }
+}
+
+template<size_t NUM_TIMERS>
+bool ESP32_ISR_TimerT<NUM_TIMERS>::startDispatchTask(const UBaseType_t& priority, const BaseType_t& core)
+{
+  static_assert( (ESP32_ISR_TIMER_DISPATCH_QUEUE_SIZE & (ESP32_ISR_TIMER_DISPATCH_QUEUE_SIZE - 1)) == 0,
+                 "ESP32_ISR_TIMER_DISPATCH_QUEUE_SIZE must be a power of 2");
+
+  if (dispatchTask != NULL)
+  {
+    return true;
+  }
+
+  // accessed from ISR, so must not be in PSRAM
+  void* memory = heap_caps_malloc(sizeof(dispatch_queue_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+
+  if (memory == NULL)
+  {
+    TISR_LOGERROR(F("Error. Can't allocate dispatch queue"));
+
+    return false;
+  }
+
+  dispatch_queue_t* queue = new (memory) dispatch_queue_t();
+
+  if (xTaskCreatePinnedToCore(dispatchTaskLoop, "ISR_Timer_dispatch", ESP32_ISR_TIMER_DISPATCH_STACK_SIZE, (void *) this,
+                              priority, (TaskHandle_t *) &dispatchTask, core) != pdPASS)
+  {
+    TISR_LOGERROR(F("Error. Can't create dispatch task"));
+
+    heap_caps_free(queue);
+
+    return false;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  dispatchQueue = queue;
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  return true;
+}
+
+template<size_t NUM_TIMERS>
+bool ESP32_ISR_TimerT<NUM_TIMERS>::setDispatch(const index_t& numTimer, const uint8_t& dispatch)
+{
+  if ( (numTimer >= NUM_TIMERS) || timer[numTimer].callback.isEmpty() )
+  {
+    return false;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  if (dispatch == TIMER_DISPATCH_TASK)
+    flags[numTimer] |= TIMER_FLAG_DEFERRED;
+  else
+    flags[numTimer] &= ~TIMER_FLAG_DEFERRED;
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  return true;
+}
+
+#if (ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE > 0)
+
+template<size_t NUM_TIMERS>
+bool IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::mustQueueCommand()
+{
+  // ISRs and run()'s own task, including the callbacks called by run(), don't wait for another run()
+  return ( !xPortInIsrContext() && (xTaskGetCurrentTaskHandle() != runTask) );
+}
+
+template<size_t NUM_TIMERS>
+bool ESP32_ISR_TimerT<NUM_TIMERS>::postCommand(const uint8_t& op, const index_t& numTimer, const esp32_isr_time_t& value)
+{
+  uint32_t slotGeneration = 0;
+
+  // timer commands of unused slots fail as when applied immediately
+  if (op < TIMER_CMD_ENABLE_ALL)
+  {
+    if (numTimer >= NUM_TIMERS)
+      return false;
+
+    slotGeneration = __atomic_load_n(&generation[numTimer], __ATOMIC_RELAXED);
+
+    if (timer[numTimer].callback.isEmpty())
+      return false;
+  }
+
+  command_t command;
+
+  command.op          = op;
+  command.numTimer    = numTimer;
+  command.generation  = slotGeneration;
+  command.value       = value;
+
+  if (!commandQueue.push(command))
+    return false;
+
+  // In tickless operation, the next run() may be far away. Have it called as soon as possible. rearmTickless() looks
+  // for ready commands after programming the alarm, so that either it or this sees the other
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  ESP32TimerInterrupt* hwTimer = ticklessTimer;
+
+  // setAlarmAfter() disables interrupts and takes the alarm lock itself, as rearmTickless() may write the alarm meanwhile
+  if (hwTimer != NULL)
+    hwTimer->setAlarmAfter(0);
+
+  return true;
+}
+
+template<size_t NUM_TIMERS>
+void IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::applyCommands(const esp32_isr_time_t& current_time)
+{
+  command_t command;
+
+  // stops at the first command claimed but not written yet, applied by a later run()
+  while (commandQueue.pop(command))
+  {
+    if ( (command.op >= TIMER_CMD_ENABLE_ALL) ||
+         ( (generation[command.numTimer] == command.generation) && !timer[command.numTimer].callback.isEmpty() ) )
+    {
+      applyCommand(command.op, command.numTimer, command.value, current_time);
+    }
+  }
+}
+
+#endif
+
+template<size_t NUM_TIMERS>
+bool IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::ticklessHandler(void* arg)
+{
+  ((ESP32_ISR_TimerT<NUM_TIMERS>*) arg)->run();
+
+  // no higher priority task woken
+  return false;
+}
+
+template<size_t NUM_TIMERS>
+void IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::rearmTickless()
+{
+  if (ticklessTimer == NULL)
+    return;
+
+  int64_t dueUs = ESP32_ISR_TIMER_TICKLESS_MAX_US;
+
+  if (heapSize > 0)
+  {
+    esp32_isr_time_t nextDeadline = deadline[heap[0]];
+    int64_t nowUs                 = esp_timer_get_time();
+
+#if ESP32_ISR_TIMER_USE_MICROS
+    int64_t deadlineUs = (esp32_isr_stime_t) (nextDeadline - (esp32_isr_time_t) nowUs);
+#else
+    // millis() is esp_timer_get_time() / 1000. Take the elapsed part of the current millisecond into account,
+    // or the alarm could be up to 1ms late
+    int64_t deadlineUs = (int64_t) (esp32_isr_stime_t) (nextDeadline - (esp32_isr_time_t) (nowUs / 1000)) * 1000
+                         - (nowUs % 1000);
+#endif
+
+    if (deadlineUs < dueUs)
+      dueUs = deadlineUs;
+  }
+
+  // already due => as soon as possible
+  ticklessTimer->setAlarmAfter( (dueUs > 0) ? (uint64_t) dueUs * (TIMER_SCALE / 1000000) : 0 );
+
+#if (ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE > 0)
+  // a command queued meanwhile by a task must be applied as soon as possible. See postCommand()
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  if (commandQueue.isReady())
+    ticklessTimer->setAlarmAfter(0);
+#endif
+}
+
+template<size_t NUM_TIMERS>
+bool ESP32_ISR_TimerT<NUM_TIMERS>::attachTicklessTimer(ESP32TimerInterrupt& hwTimer)
+{
+  if (numTimers < 0)
+  {
+    init();
+  }
+
+  // An IRAM-safe hwTimer runs the callbacks while the flash cache may be disabled
+  if (hwTimer.getInterruptIRAM())
+  {
+    for (index_t i = 0; i < (index_t) NUM_TIMERS; i++)
+    {
+      if ( !(freeMap[i >> 5] & slotBit(i)) && !timer[i].callback.isInIRAM() )
+      {
+        TISR_LOGERROR1(F("Error. IRAM-safe timer interrupt, callback must be IRAM_ATTR, timer"), i);
+
+        return false;
+      }
+    }
+  }
+
+  // The alarm stays disabled until rearmTickless() below
+  if (!hwTimer.attachInterruptFreeRunning(ticklessHandler, (void *) this))
+  {
+    return false;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  ticklessTimer = &hwTimer;
+
+  rearmTickless();
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  return true;
+}
+
+template<size_t NUM_TIMERS>
+void ESP32_ISR_TimerT<NUM_TIMERS>::detachTicklessTimer()
+{
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  if (ticklessTimer != NULL)
+  {
+    ticklessTimer->detachInterrupt();
+    ticklessTimer = NULL;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+}
+
+// true if slotA expires before slotB. Wrap-safe as long as intervals are shorter than half the time base range,
+// i.e. ~24.8 days for the millisecond time base
+template<size_t NUM_TIMERS>
+bool IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::isEarlier(const index_t slotA, const index_t slotB)
+{
+  return ( (esp32_isr_stime_t) (deadline[slotA] - deadline[slotB]) < 0 );
+}
+
+template<size_t NUM_TIMERS>
+void IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::heapSwap(const index_t posA, const index_t posB)
+{
+  index_t slot = heap[posA];
+
+  heap[posA] = heap[posB];
+  heap[posB] = slot;
+
+  heapPos[heap[posA]] = posA;
+  heapPos[heap[posB]] = posB;
+}
+
+template<size_t NUM_TIMERS>
+void IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::heapSiftUp(index_t pos)
+{
+  while (pos > 0)
+  {
+    index_t parent = (pos - 1) / 2;
+
+    if (!isEarlier(heap[pos], heap[parent]))
+      break;
+
+    heapSwap(pos, parent);
+    pos = parent;
+  }
+}
+
+template<size_t NUM_TIMERS>
+void IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::heapSiftDown(index_t pos)
+{
+  while (true)
+  {
+    // children are computed in 32 bits, as 2 * pos + 1 can overflow index_t
+    uint32_t earliest  = pos;
+    uint32_t left      = 2 * (uint32_t) pos + 1;
+    uint32_t right     = left + 1;
+
+    if ( (left < (uint32_t) heapSize) && isEarlier(heap[left], heap[earliest]) )
+      earliest = left;
+
+    if ( (right < (uint32_t) heapSize) && isEarlier(heap[right], heap[earliest]) )
+      earliest = right;
+
+    if (earliest == pos)
+      break;
+
+    heapSwap(pos, earliest);
+    pos = earliest;
+  }
+}
+
+// Must be called with timerMux held
+template<size_t NUM_TIMERS>
+void IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::heapInsert(const index_t slot)
+{
+  heap[heapSize]  = slot;
+  heapPos[slot]   = heapSize;
+
+  heapSize++;
+
+  heapSiftUp(heapSize - 1);
+}
+
+// Must be called with timerMux held
+template<size_t NUM_TIMERS>
+void IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::heapRemove(const index_t slot)
+{
+  index_t pos = heapPos[slot];
+
+  heapSize--;
+
+  if (pos != heapSize)
+  {
+    // move the last entry into the hole, then restore heap order around it
+    heapSwap(pos, heapSize);
+    heapUpdate(heap[pos]);
+  }
+}
+
+// Must be called with timerMux held, after the slot's deadline has been changed
+template<size_t NUM_TIMERS>
+void IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::heapUpdate(const index_t slot)
+{
+  heapSiftUp(heapPos[slot]);
+  heapSiftDown(heapPos[slot]);
 }
 
 
 // find the first available slot
 // return -1 if none found
-int8_t ESP32_ISR_Timer::findFirstFreeSlot()
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::findFirstFreeSlot()
 {
   // all slots are used
-  if (numTimers >= MAX_NUMBER_TIMERS)
+  if (numTimers >= (count_t) NUM_TIMERS)
   {
     return -1;
   }
 
-  // return the first slot with no callback (i.e. free)
-  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  // return the first free slot, from the first non-empty word of freeMap
+  for (size_t w = 0; w < NUM_MAP_WORDS; w++)
   {
-    if (timer[i].callback == NULL)
+    if (freeMap[w])
     {
-      return i;
+      return (w << 5) + __builtin_ctz(freeMap[w]);
     }
   }
 
@@ -179,8 +741,9 @@ int8_t ESP32_ISR_Timer::findFirstFreeSlot()
 }
 
 
-int8_t ESP32_ISR_Timer::setupTimer(const unsigned long& delay, void* callback, void* param, bool hasParam,
-                                   const uint32_t& numRuns)
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setupTimer(const esp32_isr_time_t& delay, const ESP32TimerDelegate& callback,
+                                             const uint32_t& numRuns, const uint8_t& overrun)
 {
   int freeTimer;
 
@@ -189,78 +752,322 @@ int8_t ESP32_ISR_Timer::setupTimer(const unsigned long& delay, void* callback, v
     init();
   }
 
-  freeTimer = findFirstFreeSlot();
+  if (callback.isEmpty())
+  {
+    return -1;
+  }
 
-  if (freeTimer < 0)
+  if ( (ticklessTimer != NULL) && ticklessTimer->getInterruptIRAM() && !callback.isInIRAM() )
   {
+    TISR_LOGERROR(F("Error. IRAM-safe timer interrupt, callback must be IRAM_ATTR"));
+
     return -1;
   }
 
-  if (callback == NULL)
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  freeTimer = findFirstFreeSlot();
+
+  if (freeTimer < 0)
   {
+    portEXIT_CRITICAL(&timerMux);
+
     return -1;
   }
 
-  timer[freeTimer].delay        = delay;
+  // A zero delay would keep the timer due forever. Use the shortest possible interval instead
+  period[freeTimer]             = (delay > 0) ? delay : 1;
   timer[freeTimer].callback     = callback;
-  timer[freeTimer].param        = param;
-  timer[freeTimer].hasParam     = hasParam;
+
+#if (ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE > 0)
+  __atomic_store_n(&generation[freeTimer], generation[freeTimer] + 1, __ATOMIC_RELAXED);
+#endif
   timer[freeTimer].maxNumRuns   = numRuns;
-  timer[freeTimer].enabled      = true;
-  timer[freeTimer].prev_millis  = millis();
+  flags[freeTimer]              = (overrun << TIMER_FLAG_OVERRUN_SHIFT) & TIMER_FLAG_OVERRUN_MASK;
+  deadline[freeTimer]           = now() + period[freeTimer];
+
+  freeMap[freeTimer >> 5] &= ~slotBit(freeTimer);
+  setEnabled(freeTimer, true);
+
+#if ESP32_ISR_TIMER_STATS
+  memset(&stats[freeTimer], 0, sizeof (esp32_isr_timer_stats_t));
+#endif
+
+  heapInsert(freeTimer);
 
   numTimers++;
 
+  rearmTickless();
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
   return freeTimer;
 }
 
 
-int ESP32_ISR_Timer::setTimer(const unsigned long& delay, const timer_callback& callback, const uint32_t& numRuns)
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setTimer(const unsigned long& delay, const timer_callback& callback, const uint32_t& numRuns,
+                                           const uint8_t& overrun)
+{
+  return setupTimer(msToTicks(delay), ESP32TimerDelegate(callback), numRuns, overrun);
+}
+
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setTimer(const unsigned long& delay, const timer_callback_p& callback, void* param,
+                              const uint32_t& numRuns, const uint8_t& overrun)
+{
+  return setupTimer(msToTicks(delay), ESP32TimerDelegate(callback, param), numRuns, overrun);
+}
+
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setInterval(const unsigned long& delay, const timer_callback& callback,
+                                              const uint8_t& overrun)
+{
+  return setupTimer(msToTicks(delay), ESP32TimerDelegate(callback), TIMER_RUN_FOREVER, overrun);
+}
+
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setInterval(const unsigned long& delay, const timer_callback_p& callback, void* param,
+                                              const uint8_t& overrun)
+{
+  return setupTimer(msToTicks(delay), ESP32TimerDelegate(callback, param), TIMER_RUN_FOREVER, overrun);
+}
+
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setTimeout(const unsigned long& delay, const timer_callback& callback)
+{
+  return setupTimer(msToTicks(delay), ESP32TimerDelegate(callback), TIMER_RUN_ONCE);
+}
+
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setTimeout(const unsigned long& delay, const timer_callback_p& callback, void* param)
+{
+  return setupTimer(msToTicks(delay), ESP32TimerDelegate(callback, param), TIMER_RUN_ONCE);
+}
+
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setTimerUs(const uint64_t& delayUs, const timer_callback& callback,
+                                             const uint32_t& numRuns, const uint8_t& overrun)
+{
+  return setupTimer(usToTicks(delayUs), ESP32TimerDelegate(callback), numRuns, overrun);
+}
+
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setTimerUs(const uint64_t& delayUs, const timer_callback_p& callback, void* param,
+                                             const uint32_t& numRuns, const uint8_t& overrun)
+{
+  return setupTimer(usToTicks(delayUs), ESP32TimerDelegate(callback, param), numRuns, overrun);
+}
+
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setIntervalUs(const uint64_t& delayUs, const timer_callback& callback,
+                                                const uint8_t& overrun)
+{
+  return setupTimer(usToTicks(delayUs), ESP32TimerDelegate(callback), TIMER_RUN_FOREVER, overrun);
+}
+
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setIntervalUs(const uint64_t& delayUs, const timer_callback_p& callback, void* param,
+                                                const uint8_t& overrun)
+{
+  return setupTimer(usToTicks(delayUs), ESP32TimerDelegate(callback, param), TIMER_RUN_FOREVER, overrun);
+}
+
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setTimeoutUs(const uint64_t& delayUs, const timer_callback& callback)
+{
+  return setupTimer(usToTicks(delayUs), ESP32TimerDelegate(callback), TIMER_RUN_ONCE);
+}
+
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setTimeoutUs(const uint64_t& delayUs, const timer_callback_p& callback, void* param)
+{
+  return setupTimer(usToTicks(delayUs), ESP32TimerDelegate(callback, param), TIMER_RUN_ONCE);
+}
+
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setInterval(const unsigned long& delay, const ESP32TimerDelegate& callback,
+                                              const uint8_t& overrun)
+{
+  return setupTimer(msToTicks(delay), callback, TIMER_RUN_FOREVER, overrun);
+}
+
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setTimeout(const unsigned long& delay, const ESP32TimerDelegate& callback)
+{
+  return setupTimer(msToTicks(delay), callback, TIMER_RUN_ONCE);
+}
+
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setTimer(const unsigned long& delay, const ESP32TimerDelegate& callback,
+                                           const uint32_t& numRuns, const uint8_t& overrun)
 {
-  return setupTimer(delay, (void *)callback, NULL, false, numRuns);
+  return setupTimer(msToTicks(delay), callback, numRuns, overrun);
 }
 
-int ESP32_ISR_Timer::setTimer(const unsigned long& delay, const timer_callback_p& callback, void* param,
-                              const uint32_t& numRuns)
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setIntervalUs(const uint64_t& delayUs, const ESP32TimerDelegate& callback,
+                                                const uint8_t& overrun)
 {
-  return setupTimer(delay, (void *)callback, param, true, numRuns);
+  return setupTimer(usToTicks(delayUs), callback, TIMER_RUN_FOREVER, overrun);
 }
 
-int ESP32_ISR_Timer::setInterval(const unsigned long& delay, const timer_callback& callback)
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setTimeoutUs(const uint64_t& delayUs, const ESP32TimerDelegate& callback)
 {
-  return setupTimer(delay, (void *)callback, NULL, false, TIMER_RUN_FOREVER);
+  return setupTimer(usToTicks(delayUs), callback, TIMER_RUN_ONCE);
+}
+
+template<size_t NUM_TIMERS>
+int ESP32_ISR_TimerT<NUM_TIMERS>::setTimerUs(const uint64_t& delayUs, const ESP32TimerDelegate& callback,
+                                             const uint32_t& numRuns, const uint8_t& overrun)
+{
+  return setupTimer(usToTicks(delayUs), callback, numRuns, overrun);
+}
+
+template<size_t NUM_TIMERS>
+void IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::applyCommand(const uint8_t op, const index_t numTimer,
+                                                          const esp32_isr_time_t value,
+                                                          const esp32_isr_time_t current_time)
+{
+  if (op == TIMER_CMD_ENABLE_ALL)
+  {
+    setEnabledNotRun(true);
+    return;
+  }
+
+  if (op == TIMER_CMD_DISABLE_ALL)
+  {
+    setEnabledNotRun(false);
+    return;
+  }
+
+  // only slots in use are in the heap
+  if ( (numTimer >= NUM_TIMERS) || timer[numTimer].callback.isEmpty() )
+  {
+    return;
+  }
+
+  switch (op)
+  {
+    case TIMER_CMD_CHANGE_INTERVAL:
+    case TIMER_CMD_RESTART:
+      if (op == TIMER_CMD_CHANGE_INTERVAL)
+        period[numTimer] = (value > 0) ? value : 1;
+
+      deadline[numTimer] = current_time + period[numTimer] + timer[numTimer].slack;
+
+      timer[numTimer].backlog = 0;
+
+      heapUpdate(numTimer);
+      break;
+
+    case TIMER_CMD_SET_SLACK:
+      if ( (timer[numTimer].slack == 0) && (value > 0) )
+        numSlackTimers++;
+      else if ( (timer[numTimer].slack > 0) && (value == 0) )
+        numSlackTimers--;
+
+      // keep the period boundary, only moving the latest time of the next fire
+      deadline[numTimer]     += value - timer[numTimer].slack;
+      timer[numTimer].slack   = value;
+
+      heapUpdate(numTimer);
+      break;
+
+    case TIMER_CMD_ENABLE:
+      setEnabled(numTimer, true);
+      break;
+
+    case TIMER_CMD_DISABLE:
+      setEnabled(numTimer, false);
+      break;
+
+    case TIMER_CMD_DELETE:
+      heapRemove(numTimer);
+
+      if (timer[numTimer].slack > 0)
+        numSlackTimers--;
+
+      timer[numTimer]    = timer_t();
+      flags[numTimer]    = 0;
+      period[numTimer]   = 0;
+      deadline[numTimer] = current_time;
+
+      setEnabled(numTimer, false);
+      freeMap[numTimer >> 5] |= slotBit(numTimer);
+
+      // update number of timers
+      numTimers--;
+      break;
+  }
 }
 
-int ESP32_ISR_Timer::setInterval(const unsigned long& delay, const timer_callback_p& callback, void* param)
+template<size_t NUM_TIMERS>
+bool ESP32_ISR_TimerT<NUM_TIMERS>::apply(const Batch& batch)
 {
-  return setupTimer(delay, (void *)callback, param, true, TIMER_RUN_FOREVER);
+  // all or nothing
+  if (batch.overflow)
+  {
+    return false;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  esp32_isr_time_t current_time = now();
+
+  for (uint16_t i = 0; i < batch.numCommands; i++)
+  {
+    applyCommand(batch.commands[i].op, batch.commands[i].numTimer, batch.commands[i].value, current_time);
+  }
+
+  rearmTickless();
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  return true;
 }
 
-int ESP32_ISR_Timer::setTimeout(const unsigned long& delay, const timer_callback& callback)
+template<size_t NUM_TIMERS>
+bool IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::changeInterval(const index_t& numTimer, const unsigned long& delay)
 {
-  return setupTimer(delay, (void *)callback, NULL, false, TIMER_RUN_ONCE);
+  return changeTimerInterval(numTimer, msToTicks(delay));
 }
 
-int ESP32_ISR_Timer::setTimeout(const unsigned long& delay, const timer_callback_p& callback, void* param)
+template<size_t NUM_TIMERS>
+bool IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::changeIntervalUs(const index_t& numTimer, const uint64_t& delayUs)
 {
-  return setupTimer(delay, (void *)callback, param, true, TIMER_RUN_ONCE);
+  return changeTimerInterval(numTimer, usToTicks(delayUs));
 }
 
-bool IRAM_ATTR ESP32_ISR_Timer::changeInterval(const uint8_t& numTimer, const unsigned long& delay)
+template<size_t NUM_TIMERS>
+bool IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::changeTimerInterval(const index_t& numTimer, const esp32_isr_time_t& delay)
 {
-  if (numTimer >= MAX_NUMBER_TIMERS)
+#if (ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE > 0)
+  if (mustQueueCommand())
+  {
+    return postCommand(TIMER_CMD_CHANGE_INTERVAL, numTimer, delay);
+  }
+#endif
+
+  if (numTimer >= NUM_TIMERS)
   {
     return false;
   }
 
   // Updates interval of existing specified timer
-  if (timer[numTimer].callback != NULL)
+  if (!timer[numTimer].callback.isEmpty())
   {
     // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
     portENTER_CRITICAL(&timerMux);
 
-    timer[numTimer].delay = delay;
-    timer[numTimer].prev_millis = millis();
+    applyCommand(TIMER_CMD_CHANGE_INTERVAL, numTimer, delay, now());
+
+    rearmTickless();
 
     // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
     portEXIT_CRITICAL(&timerMux);
@@ -272,136 +1079,278 @@ bool IRAM_ATTR ESP32_ISR_Timer::changeInterval(const uint8_t& numTimer, const un
   return false;
 }
 
-void ESP32_ISR_Timer::deleteTimer(const uint8_t& timerId)
+template<size_t NUM_TIMERS>
+bool ESP32_ISR_TimerT<NUM_TIMERS>::setSlack(const index_t& numTimer, const unsigned long& slack)
+{
+  return setTimerSlack(numTimer, msToTicks(slack));
+}
+
+template<size_t NUM_TIMERS>
+bool ESP32_ISR_TimerT<NUM_TIMERS>::setSlackUs(const index_t& numTimer, const uint64_t& slackUs)
+{
+  return setTimerSlack(numTimer, usToTicks(slackUs));
+}
+
+template<size_t NUM_TIMERS>
+bool ESP32_ISR_TimerT<NUM_TIMERS>::setTimerSlack(const index_t& numTimer, const esp32_isr_time_t& slack)
+{
+  if ( (numTimer >= NUM_TIMERS) || timer[numTimer].callback.isEmpty() )
+  {
+    return false;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  applyCommand(TIMER_CMD_SET_SLACK, numTimer, slack, now());
+
+  rearmTickless();
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  return true;
+}
+
+template<size_t NUM_TIMERS>
+bool ESP32_ISR_TimerT<NUM_TIMERS>::deleteTimer(const index_t& timerId)
 {
+#if (ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE > 0)
+  if (mustQueueCommand())
+  {
+    return postCommand(TIMER_CMD_DELETE, timerId, 0);
+  }
+#endif
+
   // nothing to delete if no timers are in use
-  if ( (timerId >= MAX_NUMBER_TIMERS) || (numTimers == 0) )
+  if ( (timerId >= NUM_TIMERS) || (numTimers == 0) )
   {
-    return;
+    return false;
   }
 
   // don't decrease the number of timers if the specified slot is already empty
-  if (timer[timerId].callback != NULL)
+  if (!timer[timerId].callback.isEmpty())
   {
     // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
     portENTER_CRITICAL(&timerMux);
 
-    memset((void*) &timer[timerId], 0, sizeof (timer_t));
-    timer[timerId].prev_millis = millis();
+    applyCommand(TIMER_CMD_DELETE, timerId, 0, now());
 
-    // update number of timers
-    numTimers--;
+    rearmTickless();
 
     // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
     portEXIT_CRITICAL(&timerMux);
 
+    return true;
   }
+
+  return false;
 }
 
 // function contributed by code@rowansimms.com
-void ESP32_ISR_Timer::restartTimer(const uint8_t& numTimer)
+template<size_t NUM_TIMERS>
+bool ESP32_ISR_TimerT<NUM_TIMERS>::restartTimer(const index_t& numTimer)
 {
-  if (numTimer >= MAX_NUMBER_TIMERS)
+#if (ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE > 0)
+  if (mustQueueCommand())
   {
-    return;
+    return postCommand(TIMER_CMD_RESTART, numTimer, 0);
+  }
+#endif
+
+  // false for a non-used numTimer, as when queued
+  if ( (numTimer >= NUM_TIMERS) || timer[numTimer].callback.isEmpty() )
+  {
+    return false;
   }
 
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
   portENTER_CRITICAL(&timerMux);
 
-  timer[numTimer].prev_millis = millis();
+  applyCommand(TIMER_CMD_RESTART, numTimer, 0, now());
+
+  rearmTickless();
 
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
   portEXIT_CRITICAL(&timerMux);
+
+  return true;
 }
 
 
-bool ESP32_ISR_Timer::isEnabled(const uint8_t& numTimer)
+template<size_t NUM_TIMERS>
+bool ESP32_ISR_TimerT<NUM_TIMERS>::isEnabled(const index_t& numTimer)
 {
-  if (numTimer >= MAX_NUMBER_TIMERS)
+  if (numTimer >= NUM_TIMERS)
   {
     return false;
   }
 
-  return timer[numTimer].enabled;
+  return isEnabledSlot(numTimer);
 }
 
 
-void ESP32_ISR_Timer::enable(const uint8_t& numTimer)
+template<size_t NUM_TIMERS>
+void ESP32_ISR_TimerT<NUM_TIMERS>::enable(const index_t& numTimer)
 {
-  if (numTimer >= MAX_NUMBER_TIMERS)
+  if (numTimer >= NUM_TIMERS)
   {
     return;
   }
 
-  timer[numTimer].enabled = true;
+  setEnabled(numTimer, true);
 }
 
 
-void ESP32_ISR_Timer::disable(const uint8_t& numTimer)
+template<size_t NUM_TIMERS>
+void ESP32_ISR_TimerT<NUM_TIMERS>::disable(const index_t& numTimer)
 {
-  if (numTimer >= MAX_NUMBER_TIMERS)
+  if (numTimer >= NUM_TIMERS)
   {
     return;
   }
 
-  timer[numTimer].enabled = false;
+  setEnabled(numTimer, false);
 }
 
-void ESP32_ISR_Timer::enableAll()
+template<size_t NUM_TIMERS>
+bool ESP32_ISR_TimerT<NUM_TIMERS>::enableAll()
 {
-  // Enable all timers with a callback assigned (used)
+#if (ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE > 0)
+  if (mustQueueCommand())
+  {
+    return postCommand(TIMER_CMD_ENABLE_ALL, 0, 0);
+  }
+#endif
 
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
   portENTER_CRITICAL(&timerMux);
 
-  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
-  {
-    if (timer[i].callback != NULL && timer[i].numRuns == TIMER_RUN_FOREVER)
-    {
-      timer[i].enabled = true;
-    }
-  }
+  // Enable all timers with a callback assigned (used)
+  setEnabledNotRun(true);
 
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
   portEXIT_CRITICAL(&timerMux);
+
+  return true;
 }
 
-void ESP32_ISR_Timer::disableAll()
+template<size_t NUM_TIMERS>
+bool ESP32_ISR_TimerT<NUM_TIMERS>::disableAll()
 {
-  // Disable all timers with a callback assigned (used)
+#if (ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE > 0)
+  if (mustQueueCommand())
+  {
+    return postCommand(TIMER_CMD_DISABLE_ALL, 0, 0);
+  }
+#endif
 
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
   portENTER_CRITICAL(&timerMux);
 
-  for (uint8_t i = 0; i < MAX_NUMBER_TIMERS; i++)
+  // Disable all timers with a callback assigned (used)
+  setEnabledNotRun(false);
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
+
+  return true;
+}
+
+template<size_t NUM_TIMERS>
+void IRAM_ATTR ESP32_ISR_TimerT<NUM_TIMERS>::setEnabledNotRun(const bool enabled)
+{
+  // visit only the used slots, from the complement of freeMap
+  for (size_t w = 0; w < NUM_MAP_WORDS; w++)
   {
-    if (timer[i].callback != NULL && timer[i].numRuns == TIMER_RUN_FOREVER)
+    uint32_t used = ~freeMap[w] & mapWordMask(w);
+
+    while (used)
     {
-      timer[i].enabled = false;
+      index_t i = (w << 5) + __builtin_ctz(used);
+
+      used &= used - 1;
+
+      if (timer[i].numRuns == TIMER_RUN_FOREVER)
+      {
+        setEnabled(i, enabled);
+      }
     }
   }
+}
+
+template<size_t NUM_TIMERS>
+void ESP32_ISR_TimerT<NUM_TIMERS>::toggle(const index_t& numTimer)
+{
+  if (numTimer >= NUM_TIMERS)
+  {
+    return;
+  }
+
+  __atomic_fetch_xor(&enabledMap[numTimer >> 5], slotBit(numTimer), __ATOMIC_RELAXED);
+}
+
+
+#if ESP32_ISR_TIMER_STATS
+
+template<size_t NUM_TIMERS>
+bool ESP32_ISR_TimerT<NUM_TIMERS>::getStats(const index_t& numTimer, esp32_isr_timer_stats_t& timerStats)
+{
+  if (numTimer >= NUM_TIMERS)
+  {
+    return false;
+  }
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  timerStats = stats[numTimer];
 
   // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
   portEXIT_CRITICAL(&timerMux);
 
+  return true;
 }
 
-void ESP32_ISR_Timer::toggle(const uint8_t& numTimer)
+template<size_t NUM_TIMERS>
+void ESP32_ISR_TimerT<NUM_TIMERS>::resetStats(const index_t& numTimer)
 {
-  if (numTimer >= MAX_NUMBER_TIMERS)
+  if (numTimer >= NUM_TIMERS)
   {
     return;
   }
 
-  timer[numTimer].enabled = !timer[numTimer].enabled;
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portENTER_CRITICAL(&timerMux);
+
+  memset(&stats[numTimer], 0, sizeof (esp32_isr_timer_stats_t));
+
+  // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during modifying shared vars
+  portEXIT_CRITICAL(&timerMux);
 }
 
+#endif
 
-int8_t ESP32_ISR_Timer::getNumTimers()
+template<size_t NUM_TIMERS>
+uint32_t ESP32_ISR_TimerT<NUM_TIMERS>::getElapsedPeriods()
+{
+  // TIMER_DISPATCH_TASK callbacks run in the dispatch task, outside of run()
+  if ( !xPortInIsrContext() && (dispatchTask != NULL) && (xTaskGetCurrentTaskHandle() == dispatchTask) )
+    return dispatchElapsed;
+
+  return runElapsed;
+}
+
+template<size_t NUM_TIMERS>
+typename ESP32_ISR_TimerT<NUM_TIMERS>::count_t ESP32_ISR_TimerT<NUM_TIMERS>::getNumTimers()
 {
   return numTimers;
 }
 
+// Instantiate the default ESP32_ISR_Timer here, so that files including only ESP32_ISR_Timer.hpp can use it
+// without `Multiple Definitions` Linker Error. Other capacities are instantiated where they're used, or by adding
+// template class ESP32_ISR_TimerT<N>; next to #include "ESP32_ISR_Timer.h"
+template class ESP32_ISR_TimerT<MAX_NUMBER_TIMERS>;
+
 #endif    // ISR_TIMER_GENERIC_IMPL_H
 
@@ -56,7 +56,7 @@
 #ifndef ISR_TIMER_GENERIC_HPP
 #define ISR_TIMER_GENERIC_HPP
 
-#if !defined( ESP32 )
+#if !defined( ESP32 ) && !defined( ESP32_TIMER_INTERRUPT_HOST_SIM )
   #error This code is intended to run on the ESP32 platform! Please check your Tools->Board setting.
 #endif
 
@@ -87,7 +87,11 @@
 
 #include <inttypes.h>
 
-#if defined(ARDUINO)
+#include <type_traits>
+
+#if defined(ESP32_TIMER_INTERRUPT_HOST_SIM)
+  #include "ESP32TimerInterrupt_HostSim.h"
+#elif defined(ARDUINO)
   #if ARDUINO >= 100
     #include <Arduino.h>
   #else
@@ -95,22 +99,148 @@
   #endif
 #endif
 
-#define ESP32_ISR_Timer ESP32_ISRTimer
+// Default number of timers of ESP32_ISR_Timer. Use ESP32_ISR_TimerT<N> for other capacities
+#ifndef MAX_NUMBER_TIMERS
+  #define MAX_NUMBER_TIMERS         16
+#endif
+
+#define TIMER_RUN_FOREVER           0
+#define TIMER_RUN_ONCE              1
+
+// What a periodic timer does when run() finds that more than one of its periods elapsed
+#define TIMER_OVERRUN_SKIP          0       // call once, drop the missed periods (default)
+#define TIMER_OVERRUN_BURST         1       // call once per period, up to ESP32_ISR_TIMER_BURST_MAX times per run()
+#define TIMER_OVERRUN_COALESCE      2       // call once, getElapsedPeriods() telling the number of elapsed periods
+
+// Most calls of a TIMER_OVERRUN_BURST timer in one run(). The remaining missed periods are made up in later runs
+#ifndef ESP32_ISR_TIMER_BURST_MAX
+  #define ESP32_ISR_TIMER_BURST_MAX   4
+#endif
+
+// Where the callback of a timer is executed
+#define TIMER_DISPATCH_ISR          0       // in run(), i.e. in the hardware timer ISR (default)
+#define TIMER_DISPATCH_TASK         1       // in the dispatch task started by startDispatchTask()
+
+// Number of pending TIMER_DISPATCH_TASK callbacks. Must be a power of 2
+#ifndef ESP32_ISR_TIMER_DISPATCH_QUEUE_SIZE
+  #define ESP32_ISR_TIMER_DISPATCH_QUEUE_SIZE     32
+#endif
+
+#ifndef ESP32_ISR_TIMER_DISPATCH_STACK_SIZE
+  #define ESP32_ISR_TIMER_DISPATCH_STACK_SIZE     4096
+#endif
+
+#ifndef ESP32_ISR_TIMER_DISPATCH_PRIORITY
+  #define ESP32_ISR_TIMER_DISPATCH_PRIORITY       (configMAX_PRIORITIES - 2)
+#endif
+
+// Set ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE, a power of 2, before #include to queue changeInterval(), deleteTimer(),
+// restartTimer(), enableAll() and disableAll() called from any task but the one calling run(), instead of taking
+// timerMux. These tasks then never spin on run() executing the callbacks, maybe on the other core. The queued
+// commands are applied in order at the start of the next run(). 0 (default) applies all of them immediately.
+// N.B.: with run() called from a hardware timer ISR, as usual, this includes the calls from setup() and loop(). They
+// are then asynchronous : true only means queued, for a timer in use, and e.g. getNumTimers() or isEnabled() only
+// see the change after the next run(). Only ISRs, run()'s task and the timer callbacks apply their changes at once
+#ifndef ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE
+  #define ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE      0
+#endif
+
+// Most changes recorded by an ESP32_ISR_TimerT::Batch
+#ifndef ESP32_ISR_TIMER_BATCH_SIZE
+  #define ESP32_ISR_TIMER_BATCH_SIZE              16
+#endif
+
+// Longest time a tickless hardware timer stays armed, in microseconds. Later deadlines are reached in several steps
+#ifndef ESP32_ISR_TIMER_TICKLESS_MAX_US
+  #define ESP32_ISR_TIMER_TICKLESS_MAX_US     3600000000LL
+#endif
+
+// Set ESP32_ISR_TIMER_USE_MICROS to true before #include to schedule ISR-based timers from the 64-bit, 1us
+// esp_timer_get_time() instead of millis(). Then the xxxUs() functions have full microsecond resolution and intervals
+// never wrap. Otherwise the timers tick in milliseconds, and xxxUs() intervals are rounded up to the next millisecond
+#ifndef ESP32_ISR_TIMER_USE_MICROS
+  #define ESP32_ISR_TIMER_USE_MICROS      false
+#endif
+
+// Set ESP32_ISR_TIMER_STATS to true before #include to record, per timer, the number of fires and missed periods,
+// the max and mean lateness and a lateness histogram, read by getStats(). Nothing is compiled in when false
+#ifndef ESP32_ISR_TIMER_STATS
+  #define ESP32_ISR_TIMER_STATS           false
+#endif
+
+// Number of buckets of the lateness histogram. Bucket 0 counts the fires on time, bucket k the fires late by
+// 2^(k-1) to 2^k - 1 ticks. The last bucket also counts all the later fires
+#ifndef ESP32_ISR_TIMER_STATS_BUCKETS
+  #define ESP32_ISR_TIMER_STATS_BUCKETS   8
+#endif
+
+#if !defined(ESP32_TIMER_INTERRUPT_HOST_SIM)
+  #include <esp_timer.h>
+  #include <esp_heap_caps.h>
+
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/task.h>
+#endif
+
+#include "ESP32TimerInterrupt.hpp"
+#include "ESP32SPSCRing.hpp"
+#include "ESP32MPSCRing.hpp"
+#include "ESP32TimerDelegate.hpp"
+
+#include <new>
+
+#if ESP32_ISR_TIMER_USE_MICROS
+  // time base tick in microseconds
+  typedef uint64_t        esp32_isr_time_t;
+  typedef int64_t         esp32_isr_stime_t;
+
+  #define ESP32_ISR_TIMER_TICKS_PER_MS    1000
+#else
+  // time base tick in milliseconds, wrapping after ~49.7 days
+  typedef unsigned long   esp32_isr_time_t;
+  typedef long            esp32_isr_stime_t;
+
+  #define ESP32_ISR_TIMER_TICKS_PER_MS    1
+#endif
 
 typedef void (*timer_callback)();
 typedef void (*timer_callback_p)(void *);
 
-class ESP32_ISR_Timer 
+// Timing statistics of an ISR-based timer, with ESP32_ISR_TIMER_STATS. The lateness of a fire is the time, in time
+// base ticks, from the last deadline passed to the run() calling the callback
+typedef struct
+{
+  uint32_t      numFires;                                   // number of callbacks called or dispatched
+  uint32_t      numMissed;                                  // number of periods skipped because run() was too late
+  uint32_t      maxLateness;
+  uint64_t      sumLateness;                                // mean lateness = sumLateness / numFires
+  uint32_t      histogram[ESP32_ISR_TIMER_STATS_BUCKETS];   // number of fires per lateness bucket
+} esp32_isr_timer_stats_t;
+
+// Narrowest types able to hold a slot index / a timer count for NUM_TIMERS timers
+// count_t is signed, as numTimers == -1 means uninitialized
+template<size_t NUM_TIMERS>
+struct ESP32_ISR_TimerTraits
+{
+  static_assert(NUM_TIMERS > 0, "ESP32_ISR_TimerT needs at least one timer");
+  static_assert(NUM_TIMERS <= UINT16_MAX, "ESP32_ISR_TimerT supports up to 65535 timers");
+
+  typedef typename std::conditional < (NUM_TIMERS <= UINT8_MAX), uint8_t, uint16_t >::type  index_t;
+
+  typedef typename std::conditional < (NUM_TIMERS <= INT8_MAX), int8_t,
+          typename std::conditional < (NUM_TIMERS <= INT16_MAX), int16_t, int32_t >::type >::type   count_t;
+};
+
+template<size_t NUM_TIMERS>
+class ESP32_ISR_TimerT
 {
 
   public:
-    // maximum number of timers
-#define MAX_NUMBER_TIMERS        	16
-#define TIMER_RUN_FOREVER       	0
-#define TIMER_RUN_ONCE          	1
+    typedef typename ESP32_ISR_TimerTraits<NUM_TIMERS>::index_t  index_t;
+    typedef typename ESP32_ISR_TimerTraits<NUM_TIMERS>::count_t  count_t;
 
     // constructor
-    ESP32_ISR_Timer();
+    ESP32_ISR_TimerT();
 
     void init();
 
@@ -118,14 +248,17 @@ class ESP32_ISR_Timer
     void IRAM_ATTR run();
 
     // Timer will call function 'callback' every 'delay' milliseconds forever
+    // 'overrun' is TIMER_OVERRUN_SKIP, TIMER_OVERRUN_BURST or TIMER_OVERRUN_COALESCE
     // returns the timer number (numTimer) on success or
     // -1 on failure (callback == NULL) or no free timers
-    int setInterval(const unsigned long& delay, const timer_callback& callback);
+    int setInterval(const unsigned long& delay, const timer_callback& callback,
+                    const uint8_t& overrun = TIMER_OVERRUN_SKIP);
 
     // Timer will call function 'callback' with parameter 'param' every 'delay' milliseconds forever
     // returns the timer number (numTimer) on success or
     // -1 on failure (callback == NULL) or no free timers
-    int setInterval(const unsigned long& delay, const timer_callback_p& callback, void* param);
+    int setInterval(const unsigned long& delay, const timer_callback_p& callback, void* param,
+                    const uint8_t& overrun = TIMER_OVERRUN_SKIP);
 
     // Timer will call function 'callback' after 'delay' milliseconds one time
     // returns the timer number (numTimer) on success or
@@ -140,50 +273,241 @@ class ESP32_ISR_Timer
     // Timer will call function 'callback' every 'delay' milliseconds 'numRuns' times
     // returns the timer number (numTimer) on success or
     // -1 on failure (callback == NULL) or no free timers
-    int setTimer(const unsigned long& delay, const timer_callback& callback, const uint32_t& numRuns);
+    int setTimer(const unsigned long& delay, const timer_callback& callback, const uint32_t& numRuns,
+                 const uint8_t& overrun = TIMER_OVERRUN_SKIP);
 
     // Timer will call function 'callback' with parameter 'param' every 'delay' milliseconds 'numRuns' times
     // returns the timer number (numTimer) on success or
     // -1 on failure (callback == NULL) or no free timers
-    int setTimer(const unsigned long& delay, const timer_callback_p& callback, void* param, const uint32_t& numRuns);
+    int setTimer(const unsigned long& delay, const timer_callback_p& callback, void* param, const uint32_t& numRuns,
+                 const uint8_t& overrun = TIMER_OVERRUN_SKIP);
+
+    // Same as above, with 'delay' in microseconds
+    int setIntervalUs(const uint64_t& delayUs, const timer_callback& callback,
+                      const uint8_t& overrun = TIMER_OVERRUN_SKIP);
+    int setIntervalUs(const uint64_t& delayUs, const timer_callback_p& callback, void* param,
+                      const uint8_t& overrun = TIMER_OVERRUN_SKIP);
+    int setTimeoutUs(const uint64_t& delayUs, const timer_callback& callback);
+    int setTimeoutUs(const uint64_t& delayUs, const timer_callback_p& callback, void* param);
+    int setTimerUs(const uint64_t& delayUs, const timer_callback& callback, const uint32_t& numRuns,
+                   const uint8_t& overrun = TIMER_OVERRUN_SKIP);
+    int setTimerUs(const uint64_t& delayUs, const timer_callback_p& callback, void* param, const uint32_t& numRuns,
+                   const uint8_t& overrun = TIMER_OVERRUN_SKIP);
+
+    // Same as above, calling an ESP32TimerDelegate: a lambda with captures, or an object and a member function.
+    // -1 on failure (empty callback) or no free timers
+    int setInterval(const unsigned long& delay, const ESP32TimerDelegate& callback,
+                    const uint8_t& overrun = TIMER_OVERRUN_SKIP);
+    int setTimeout(const unsigned long& delay, const ESP32TimerDelegate& callback);
+    int setTimer(const unsigned long& delay, const ESP32TimerDelegate& callback, const uint32_t& numRuns,
+                 const uint8_t& overrun = TIMER_OVERRUN_SKIP);
+    int setIntervalUs(const uint64_t& delayUs, const ESP32TimerDelegate& callback,
+                      const uint8_t& overrun = TIMER_OVERRUN_SKIP);
+    int setTimeoutUs(const uint64_t& delayUs, const ESP32TimerDelegate& callback);
+    int setTimerUs(const uint64_t& delayUs, const ESP32TimerDelegate& callback, const uint32_t& numRuns,
+                   const uint8_t& overrun = TIMER_OVERRUN_SKIP);
+
+    // Number of periods the running timer callback stands for. 1, except for a TIMER_OVERRUN_COALESCE timer
+    // which missed periods. Only meaningful when called from inside a timer callback
+    uint32_t getElapsedPeriods();
+
+    // With ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE, the 5 functions below return false if the command queue is full
 
     // updates interval of the specified timer
-    bool changeInterval(const uint8_t& numTimer, const unsigned long& delay);
+    bool changeInterval(const index_t& numTimer, const unsigned long& delay);
+
+    // updates interval, in microseconds, of the specified timer
+    bool changeIntervalUs(const index_t& numTimer, const uint64_t& delayUs);
 
     // destroy the specified timer
-    void deleteTimer(const uint8_t& numTimer);
+    bool deleteTimer(const index_t& numTimer);
 
     // restart the specified timer
-    void restartTimer(const uint8_t& numTimer);
+    bool restartTimer(const index_t& numTimer);
 
     // returns true if the specified timer is enabled
-    bool isEnabled(const uint8_t& numTimer);
+    bool isEnabled(const index_t& numTimer);
 
     // enables the specified timer
-    void enable(const uint8_t& numTimer);
+    void enable(const index_t& numTimer);
 
     // disables the specified timer
-    void disable(const uint8_t& numTimer);
+    void disable(const index_t& numTimer);
 
     // enables all timers
-    void enableAll();
+    bool enableAll();
 
     // disables all timers
-    void disableAll();
+    bool disableAll();
 
     // enables the specified timer if it's currently disabled, and vice-versa
-    void toggle(const uint8_t& numTimer);
+    void toggle(const index_t& numTimer);
+
+    // Timer mutations, applied by applyCommand(). The ones before TIMER_CMD_ENABLE_ALL apply to one timer
+#define TIMER_CMD_CHANGE_INTERVAL   0       // 'value' is the new delay, in time base ticks
+#define TIMER_CMD_DELETE            1
+#define TIMER_CMD_RESTART           2
+#define TIMER_CMD_ENABLE            3
+#define TIMER_CMD_DISABLE           4
+#define TIMER_CMD_SET_SLACK         5       // 'value' is the new slack, in time base ticks
+#define TIMER_CMD_ENABLE_ALL        6
+#define TIMER_CMD_DISABLE_ALL       7
+
+    // Timer changes collected, to be applied by apply() all together, from the same current time, in a single
+    // critical section. run() then never sees a part of them only
+    class Batch
+    {
+      public:
+        Batch() : numCommands(0), overflow(false) {};
+
+        // Same as the ESP32_ISR_TimerT functions, but only recorded. Return false if the batch is full
+        bool changeInterval(const index_t& numTimer, const unsigned long& delay)
+        {
+          return add(TIMER_CMD_CHANGE_INTERVAL, numTimer, msToTicks(delay));
+        };
+
+        bool changeIntervalUs(const index_t& numTimer, const uint64_t& delayUs)
+        {
+          return add(TIMER_CMD_CHANGE_INTERVAL, numTimer, usToTicks(delayUs));
+        };
+
+        bool deleteTimer(const index_t& numTimer)
+        {
+          return add(TIMER_CMD_DELETE, numTimer, 0);
+        };
+
+        bool restartTimer(const index_t& numTimer)
+        {
+          return add(TIMER_CMD_RESTART, numTimer, 0);
+        };
+
+        bool enable(const index_t& numTimer)
+        {
+          return add(TIMER_CMD_ENABLE, numTimer, 0);
+        };
+
+        bool disable(const index_t& numTimer)
+        {
+          return add(TIMER_CMD_DISABLE, numTimer, 0);
+        };
+
+        bool setSlack(const index_t& numTimer, const unsigned long& slack)
+        {
+          return add(TIMER_CMD_SET_SLACK, numTimer, msToTicks(slack));
+        };
+
+        bool setSlackUs(const index_t& numTimer, const uint64_t& slackUs)
+        {
+          return add(TIMER_CMD_SET_SLACK, numTimer, usToTicks(slackUs));
+        };
+
+        bool enableAll()
+        {
+          return add(TIMER_CMD_ENABLE_ALL, 0, 0);
+        };
+
+        bool disableAll()
+        {
+          return add(TIMER_CMD_DISABLE_ALL, 0, 0);
+        };
+
+        // forget all the changes, to reuse the batch
+        void clear()
+        {
+          numCommands = 0;
+          overflow    = false;
+        };
+
+      private:
+        friend class ESP32_ISR_TimerT;
+
+        bool add(const uint8_t op, const index_t numTimer, const esp32_isr_time_t value)
+        {
+          if (numCommands >= ESP32_ISR_TIMER_BATCH_SIZE)
+          {
+            overflow = true;
+
+            return false;
+          }
+
+          commands[numCommands].op        = op;
+          commands[numCommands].numTimer  = numTimer;
+          commands[numCommands].value     = value;
+
+          numCommands++;
+
+          return true;
+        };
+
+        struct
+        {
+          uint8_t           op;           // TIMER_CMD_xxx
+          index_t           numTimer;
+          esp32_isr_time_t  value;
+        } commands[ESP32_ISR_TIMER_BATCH_SIZE];
+
+        uint16_t  numCommands;
+        bool      overflow;               // a change couldn't be recorded
+    };
+
+    // Apply the changes of 'batch', in order. Changes of unused timers are ignored.
+    // Returns false, applying nothing, if the batch overflowed
+    bool apply(const Batch& batch);
+
+    // Tickless operation: take over 'hwTimer' and program its alarm to the earliest pending deadline, so that it only
+    // interrupts when a timer is due, instead of at a fixed rate. run() is then called from hwTimer's ISR, and must not
+    // be called anywhere else. Don't use hwTimer for anything else while attached.
+    // If hwTimer is IRAM-safe (ESP32TimerInterrupt::setInterruptIRAM()), all callbacks, TIMER_DISPATCH_TASK ones
+    // included, must be IRAM_ATTR: attaching and setting up timers fail otherwise
+    bool attachTicklessTimer(ESP32TimerInterrupt& hwTimer);
+
+    // stop tickless operation and disable hwTimer's interrupt
+    void detachTicklessTimer();
+
+    // Start the task running TIMER_DISPATCH_TASK callbacks, with the specified priority, on the specified core
+    // (tskNO_AFFINITY: any core). Call once, before setDispatch()
+    bool startDispatchTask(const UBaseType_t& priority = ESP32_ISR_TIMER_DISPATCH_PRIORITY,
+                           const BaseType_t& core = tskNO_AFFINITY);
+
+    // Select where the callback of the specified timer is executed, TIMER_DISPATCH_ISR or TIMER_DISPATCH_TASK.
+    // A TIMER_DISPATCH_TASK callback doesn't hold timerMux, and so can be slow without delaying interrupts.
+    // Until startDispatchTask() is called, all callbacks are executed in run()
+    bool setDispatch(const index_t& numTimer, const uint8_t& dispatch);
+
+    // Let the specified timer fire up to 'slack' milliseconds after its period boundary, so that it can be batched
+    // with other timers: whenever a timer can't wait any longer, all the timers past their period boundary fire in
+    // the same run(). In tickless operation, the alarm is programmed to the end of the earliest slack window, so
+    // the hardware timer interrupts less often. The period boundaries don't move, whatever the actual fire times.
+    // Should be less than the period, 0 (default) meaning fire on time
+    bool setSlack(const index_t& numTimer, const unsigned long& slack);
+
+    // Same as above, with 'slack' in microseconds
+    bool setSlackUs(const index_t& numTimer, const uint64_t& slackUs);
+
+    // returns the number of TIMER_DISPATCH_TASK callbacks dropped because the dispatch queue was full
+    uint32_t getDispatchOverruns() __attribute__((always_inline))
+    {
+      return dispatchOverruns;
+    };
+
+#if ESP32_ISR_TIMER_STATS
+    // Copy the statistics of the specified timer, as a consistent snapshot. Can be called from any task.
+    // Statistics are cleared when a timer is created in the slot
+    bool getStats(const index_t& numTimer, esp32_isr_timer_stats_t& stats);
+
+    void resetStats(const index_t& numTimer);
+#endif
 
     // returns the number of used timers
-    int8_t getNumTimers();
+    count_t getNumTimers();
 
     // returns the number of available timers
-    uint8_t getNumAvailableTimers() __attribute__((always_inline))
+    index_t getNumAvailableTimers() __attribute__((always_inline))
     {
       if (numTimers <= 0)
-        return MAX_NUMBER_TIMERS;
-      else 
-        return MAX_NUMBER_TIMERS - numTimers;
+        return NUM_TIMERS;
+      else
+        return NUM_TIMERS - numTimers;
     };
 
   private:
@@ -194,34 +518,330 @@ class ESP32_ISR_Timer
 
     // low level function to initialize and enable a new timer
     // returns the timer number (numTimer) on success or
-    // -1 on failure (f == NULL) or no free timers
-    int8_t setupTimer(const unsigned long& delay, void* callback, void* param, bool hasParam, const uint32_t& numRuns) ;
+    // -1 on failure (empty callback) or no free timers
+    // 'delay' is in time base ticks
+    int setupTimer(const esp32_isr_time_t& delay, const ESP32TimerDelegate& callback, const uint32_t& numRuns,
+                   const uint8_t& overrun = TIMER_OVERRUN_SKIP);
 
-    // find the first available slot
-    int8_t findFirstFreeSlot();
+    // 'delay' is in time base ticks
+    bool changeTimerInterval(const index_t& numTimer, const esp32_isr_time_t& delay);
+
+    // 'slack' is in time base ticks
+    bool setTimerSlack(const index_t& numTimer, const esp32_isr_time_t& slack);
+
+    // Apply a TIMER_CMD_xxx mutation at current_time. Does nothing for an unused slot. Must be called with timerMux held,
+    // followed by rearmTickless()
+    void IRAM_ATTR applyCommand(const uint8_t op, const index_t numTimer, const esp32_isr_time_t value,
+                                const esp32_isr_time_t current_time);
+
+    // Account a fire of the specified timer and move it to its next deadline. Returns a TIMER_DEFCALL_xxx
+    uint8_t IRAM_ATTR fireTimer(const index_t i, const esp32_isr_time_t& current_time);
+
+    // hwTimer's ISR in tickless operation. 'arg' is the ESP32_ISR_TimerT
+    static bool IRAM_ATTR ticklessHandler(void* arg);
+
+    // Program the tickless hardware timer alarm to the earliest deadline. Must be called with timerMux held,
+    // after any change of the heap top. Does nothing if not in tickless operation
+    void IRAM_ATTR rearmTickless();
+
+    // Queue a TIMER_DISPATCH_TASK callback. Single producer, must be called with timerMux held.
+    // Returns false if the queue is full
+    bool IRAM_ATTR dispatchPush(const index_t& numTimer, const uint32_t& elapsed);
+
+    // dispatch task body. 'arg' is the ESP32_ISR_TimerT
+    static void dispatchTaskLoop(void* arg);
+
+#if (ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE > 0)
+    // true if a mutation called now must be queued : from a task, but not the one calling run()
+    bool IRAM_ATTR mustQueueCommand();
+
+    // Queue a command. Multiple producers, lock-free. Returns false if the queue is full
+    bool postCommand(const uint8_t& op, const index_t& numTimer, const esp32_isr_time_t& value);
+
+    // Apply all the ready commands. Single consumer, must be called with timerMux held, by run()
+    void IRAM_ATTR applyCommands(const esp32_isr_time_t& current_time);
+#endif
+
+    // current time, in time base ticks
+    static esp32_isr_time_t IRAM_ATTR now() __attribute__((always_inline))
+    {
+#if ESP32_ISR_TIMER_USE_MICROS
+      return (esp32_isr_time_t) esp_timer_get_time();
+#else
+      return millis();
+#endif
+    };
+
+    static esp32_isr_time_t msToTicks(const unsigned long& ms) __attribute__((always_inline))
+    {
+      return (esp32_isr_time_t) ms * ESP32_ISR_TIMER_TICKS_PER_MS;
+    };
+
+    // Rounded up, so that a timer never fires earlier than requested
+    static esp32_isr_time_t usToTicks(const uint64_t& us) __attribute__((always_inline))
+    {
+#if ESP32_ISR_TIMER_USE_MICROS
+      return us;
+#else
+      return (esp32_isr_time_t) ( (us + 999) / 1000 );
+#endif
+    };
+
+#if ESP32_ISR_TIMER_STATS
+    // Account a fire of the specified timer. Must be called with timerMux held
+    void IRAM_ATTR recordStats(const index_t numTimer, const esp32_isr_time_t lateness,
+                               const esp32_isr_time_t missed) __attribute__((always_inline))
+    {
+      esp32_isr_timer_stats_t* timerStats = &stats[numTimer];
+
+      uint32_t late = ( (uint64_t) lateness > UINT32_MAX) ? UINT32_MAX : (uint32_t) lateness;
+
+      // bucket = number of significant bits of late
+      uint32_t bucket = late ? 32 - __builtin_clz(late) : 0;
+
+      timerStats->numFires++;
+      timerStats->numMissed   += (uint32_t) missed;
+      timerStats->sumLateness += late;
+
+      if (late > timerStats->maxLateness)
+        timerStats->maxLateness = late;
 
-    typedef struct 
+      timerStats->histogram[ (bucket < ESP32_ISR_TIMER_STATS_BUCKETS) ? bucket : ESP32_ISR_TIMER_STATS_BUCKETS - 1]++;
+    };
+#endif
+
+    static uint32_t IRAM_ATTR slotBit(const index_t slot) __attribute__((always_inline))
+    {
+      return 1UL << (slot & 31);
+    };
+
+    // bits of freeMap / enabledMap word w standing for a slot
+    static uint32_t mapWordMask(const size_t w) __attribute__((always_inline))
+    {
+      return ( (w + 1) * 32 <= NUM_TIMERS) ? 0xFFFFFFFFUL : (1UL << (NUM_TIMERS & 31)) - 1;
+    };
+
+    bool IRAM_ATTR isEnabledSlot(const index_t slot) __attribute__((always_inline))
+    {
+      return (__atomic_load_n(&enabledMap[slot >> 5], __ATOMIC_RELAXED) & slotBit(slot)) != 0;
+    };
+
+    void IRAM_ATTR setEnabled(const index_t slot, const bool enabled) __attribute__((always_inline))
+    {
+      if (enabled)
+        __atomic_fetch_or(&enabledMap[slot >> 5], slotBit(slot), __ATOMIC_RELAXED);
+      else
+        __atomic_fetch_and(&enabledMap[slot >> 5], ~slotBit(slot), __ATOMIC_RELAXED);
+    };
+
+    // mark all slots free and disabled
+    void clearSlotMaps();
+
+    // Enable or disable the used timers which haven't run yet. Forever timers never count their runs.
+    // Must be called with timerMux held
+    void IRAM_ATTR setEnabledNotRun(const bool enabled);
+
+    // find the first available slot
+    int findFirstFreeSlot();
+
+    // Deadline-ordered min-heap of active slots. heap[0] is always the slot expiring first, so run()
+    // only looks at the heap top when nothing is due, and pays O(log n) per fired timer
+    // heapPos[slot] is the position of the slot inside heap[], needed to re-key / remove in O(log n)
+    bool IRAM_ATTR isEarlier(const index_t slotA, const index_t slotB);
+    void IRAM_ATTR heapSwap(const index_t posA, const index_t posB);
+    void IRAM_ATTR heapSiftUp(index_t pos);
+    void IRAM_ATTR heapSiftDown(index_t pos);
+    void IRAM_ATTR heapInsert(const index_t slot);
+    void IRAM_ATTR heapRemove(const index_t slot);
+    void IRAM_ATTR heapUpdate(const index_t slot);
+
+    // The slot table is split by access pattern. Everything but numTimers and enabledMap is only accessed with
+    // timerMux held, which is also a compiler barrier, so needs no volatile
+
+    // Hot timing data, read by every heap comparison. In time base ticks
+    esp32_isr_time_t deadline[NUM_TIMERS];      // latest time of the next fire, i.e. next period boundary + slack.
+                                                // Absolute, compared wrap-safe
+    esp32_isr_time_t period[NUM_TIMERS];        // delay value
+
+    // Cold data, only read when a timer fires or is changed
+    typedef struct
     {
-      unsigned long prev_millis;        // value returned by the millis() function in the previous run() call
-      void*         callback;           // pointer to the callback function
-      void*         param;              // function parameter
-      bool          hasParam;           // true if callback takes a parameter
-      unsigned long delay;              // delay value
+      ESP32TimerDelegate callback;      // empty if the slot is free
       uint32_t      maxNumRuns;         // number of runs to be executed
       uint32_t      numRuns;            // number of executed runs
-      bool          enabled;            // true if enabled
-      unsigned      toBeCalled;         // deferred function call (sort of) - N.B.: only used in run()
+      uint32_t      pending;            // periods accounted for by the coming call(s) - N.B.: only used in run()
+      uint32_t      backlog;            // missed periods still to be made up by a TIMER_OVERRUN_BURST timer
+      esp32_isr_time_t slack;           // longest delay of a fire after its period boundary, in time base ticks
     } timer_t;
 
-    volatile timer_t timer[MAX_NUMBER_TIMERS];
+    timer_t timer[NUM_TIMERS];
+
+    // Per-slot flags
+#define TIMER_FLAG_DEFERRED       0x02    // TIMER_DISPATCH_TASK
+#define TIMER_FLAG_CALL_SHIFT     2       // TIMER_DEFCALL_xxx deferred function call (sort of), only used in run()
+#define TIMER_FLAG_CALL_MASK      (0x03 << TIMER_FLAG_CALL_SHIFT)
+#define TIMER_FLAG_OVERRUN_SHIFT  4       // TIMER_OVERRUN_xxx
+#define TIMER_FLAG_OVERRUN_MASK   (0x03 << TIMER_FLAG_OVERRUN_SHIFT)
+
+    uint8_t flags[NUM_TIMERS];
+
+    uint8_t IRAM_ATTR toBeCalled(const index_t slot) __attribute__((always_inline))
+    {
+      return (flags[slot] & TIMER_FLAG_CALL_MASK) >> TIMER_FLAG_CALL_SHIFT;
+    };
+
+    uint8_t IRAM_ATTR overrunPolicy(const index_t slot) __attribute__((always_inline))
+    {
+      return (flags[slot] & TIMER_FLAG_OVERRUN_MASK) >> TIMER_FLAG_OVERRUN_SHIFT;
+    };
+
+    void IRAM_ATTR setToBeCalled(const index_t slot, const uint8_t defCall) __attribute__((always_inline))
+    {
+      flags[slot] = (flags[slot] & ~TIMER_FLAG_CALL_MASK) | (defCall << TIMER_FLAG_CALL_SHIFT);
+    };
+
+    // Slot sets as bitmaps of 32-bit words, slot i being bit (i & 31) of word (i >> 5). Scanned with ctz
+    static const size_t NUM_MAP_WORDS = (NUM_TIMERS + 31) / 32;
+
+    // free slots
+    uint32_t freeMap[NUM_MAP_WORDS];
+
+    // enabled timers. Modified with atomic read-modify-write, so enable() / disable() / toggle() need no lock
+    volatile uint32_t enabledMap[NUM_MAP_WORDS];
 
     // actual number of timers in use (-1 means uninitialized)
-    volatile int8_t numTimers;
+    volatile count_t numTimers;
+
+    index_t heap[NUM_TIMERS];
+    index_t heapPos[NUM_TIMERS];
+
+    // number of slots currently in heap[]
+    count_t heapSize;
+
+    // Slots to call in the current run(), in firing order. Only accessed by run() with timerMux held. A member
+    // rather than a local, as the ISR stack couldn't hold it for large NUM_TIMERS
+    index_t dueList[NUM_TIMERS];
+
+    // number of timers with a slack. run() only looks for timers to batch when there are some
+    count_t numSlackTimers;
+
+#if ESP32_ISR_TIMER_STATS
+    esp32_isr_timer_stats_t stats[NUM_TIMERS];
+#endif
+
+    // hardware timer in tickless operation, NULL if run() is called by the user
+    ESP32TimerInterrupt* volatile ticklessTimer;
+
+    // TIMER_DISPATCH_TASK callback, as queued by run()
+    typedef struct
+    {
+      ESP32TimerDelegate callback;
+      uint32_t      elapsed;            // getElapsedPeriods() of the call
+    } dispatch_t;
+
+    typedef ESP32SPSCRing<dispatch_t, ESP32_ISR_TIMER_DISPATCH_QUEUE_SIZE> dispatch_queue_t;
+
+    // run() is the producer, the dispatch task the consumer. Allocated by startDispatchTask()
+    dispatch_queue_t* dispatchQueue;
+    volatile uint32_t dispatchOverruns;
+
+    TaskHandle_t      dispatchTask;
+
+    // getElapsedPeriods() of the callback running in run() / in the dispatch task
+    uint32_t          runElapsed;
+    uint32_t          dispatchElapsed;
+
+#if (ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE > 0)
+    static_assert( (ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE & (ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE - 1)) == 0,
+                   "ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE must be a power of 2");
+
+    // Mutation queued by a task
+    typedef struct
+    {
+      uint8_t           op;             // TIMER_CMD_xxx
+      index_t           numTimer;
+      uint32_t          generation;     // generation of numTimer when queued. Not applied if the slot got reused since
+      esp32_isr_time_t  value;          // TIMER_CMD_CHANGE_INTERVAL delay, in time base ticks
+    } command_t;
+
+    // Any task is a producer, run() the consumer
+    ESP32MPSCRing<command_t, ESP32_ISR_TIMER_COMMAND_QUEUE_SIZE>  commandQueue;
+
+    // task calling run(), whose mutations are applied immediately. NULL if run() is called from an ISR
+    TaskHandle_t      runTask;
+
+    // Incremented each time the slot is given to a new timer, so that a command queued for a deleted timer is never
+    // applied to the next one in the slot, even with the same callback. Never reset, not even by init()
+    uint32_t          generation[NUM_TIMERS];
+#endif
 
     // ESP32 is a multi core / multi processing chip. It is mandatory to disable task switches during ISR
     portMUX_TYPE timerMux = portMUX_INITIALIZER_UNLOCKED;
 };
 
+// The original 16-timer class
+typedef ESP32_ISR_TimerT<MAX_NUMBER_TIMERS>   ESP32_ISRTimer;
+
+#define ESP32_ISR_Timer ESP32_ISRTimer
+
+// One ESP32_ISR_TimerT per core, each in tickless operation on its own hardware timer, whose interrupt is serviced
+// by that core. The callbacks of the timers of a shard run on its core, so that the ISR load can be spread over
+// the cores, away from the one busy with WiFi for example. Timer numbers are per shard
+template<size_t NUM_TIMERS>
+class ESP32_ISR_TimerShardsT
+{
+  public:
+    // Drive the shard of 'core' with 'hwTimer'. Don't use hwTimer for anything else while attached
+    bool attach(const BaseType_t& core, ESP32TimerInterrupt& hwTimer)
+    {
+      if ( (core < 0) || (core >= portNUM_PROCESSORS) || !hwTimer.setInterruptCore(core) )
+      {
+        return false;
+      }
+
+      return shards[core].attachTicklessTimer(hwTimer);
+    };
+
+    void detach(const BaseType_t& core)
+    {
+      if ( (core >= 0) && (core < portNUM_PROCESSORS) )
+      {
+        shards[core].detachTicklessTimer();
+      }
+    };
+
+    // the shard of 'core', to create timers running on that core
+    ESP32_ISR_TimerT<NUM_TIMERS>& operator[](const BaseType_t& core) __attribute__((always_inline))
+    {
+      return shards[core];
+    };
+
+    // the shard of the calling core
+    ESP32_ISR_TimerT<NUM_TIMERS>& local() __attribute__((always_inline))
+    {
+      return shards[xPortGetCoreID()];
+    };
+
+    // the core whose shard has the fewest timers, to place a new timer
+    BaseType_t leastUsed()
+    {
+      BaseType_t core = 0;
+
+      for (BaseType_t c = 1; c < portNUM_PROCESSORS; c++)
+      {
+        if (shards[c].getNumAvailableTimers() > shards[core].getNumAvailableTimers())
+          core = c;
+      }
+
+      return core;
+    };
+
+  private:
+    ESP32_ISR_TimerT<NUM_TIMERS> shards[portNUM_PROCESSORS];
+};
+
+typedef ESP32_ISR_TimerShardsT<MAX_NUMBER_TIMERS>   ESP32_ISR_TimerShards;
+
 #endif    // ISR_TIMER_GENERIC_HPP
 
 
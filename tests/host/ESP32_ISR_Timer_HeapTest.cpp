@@ -0,0 +1,344 @@
+/****************************************************************************************************************************
+  ESP32_ISR_Timer_HeapTest.cpp
+  For ESP32, ESP32_S2, ESP32_S3, ESP32_C3 boards with ESP32 core v2.0.2+
+  Written by Khoi Hoang
+
+  Built by Khoi Hoang https://github.com/khoih-prog/ESP32TimerInterrupt
+  Licensed under MIT license
+
+  Host test of the deadline-ordered min-heap scheduler of ESP32_ISR_Timer, run against the host simulation.
+  Randomized setInterval() / setTimer() / changeInterval() / deleteTimer() / restartTimer() / enable() / disable() /
+  toggle() / enableAll() / disableAll() sequences are applied to both ESP32_ISR_Timer and LinearTimers, a linear scan
+  of all the slots on every run() as the original SimpleTimer-based ESP32_ISR_Timer did. After every run(), both must
+  have called the same callbacks, and agree on the number of timers and the enabled ones. Their mutations must also
+  return the same, false for an unused slot.
+
+  Time is the virtual clock of ESP32TimerInterrupt_HostSim.h, advanced by 1 to 5ms between two run().
+
+  Version: 2.3.0
+
+  Version Modified By   Date      Comments
+  ------- -----------  ---------- -----------
+  2.3.0   K Hoang      16/11/2022 Fix doubled time for ESP32_C3, ESP32_S2 and ESP32_S3
+*****************************************************************************************************************************/
+
+#include "ESP32TimerInterrupt.h"
+
+#include <algorithm>
+#include <vector>
+
+#define NUM_SEEDS           8
+#define NUM_STEPS           20000
+
+// Reference scheduler : every run() checks all the slots against their last period boundary
+class LinearTimers
+{
+  public:
+    LinearTimers() : numTimers(0)
+    {
+      for (int i = 0; i < MAX_NUMBER_TIMERS; i++)
+        clearSlot(i);
+    };
+
+    int setTimer(const unsigned long& delay, const int& tag, const uint32_t& numRuns)
+    {
+      for (int i = 0; i < MAX_NUMBER_TIMERS; i++)
+      {
+        if (!slot[i].used)
+        {
+          slot[i].used        = true;
+          slot[i].enabled     = true;
+          slot[i].delay       = delay;
+          slot[i].prevMillis  = millis();
+          slot[i].tag         = tag;
+          slot[i].maxNumRuns  = numRuns;
+          slot[i].numRuns     = 0;
+
+          numTimers++;
+
+          return i;
+        }
+      }
+
+      return -1;
+    };
+
+    // the mutations return false for an unused slot, as ESP32_ISR_Timer ones
+    bool changeInterval(const int& i, const unsigned long& delay)
+    {
+      if (slot[i].used)
+      {
+        slot[i].delay       = delay;
+        slot[i].prevMillis  = millis();
+      }
+
+      return slot[i].used;
+    };
+
+    bool deleteTimer(const int& i)
+    {
+      if (!slot[i].used)
+        return false;
+
+      clearSlot(i);
+      numTimers--;
+
+      return true;
+    };
+
+    bool restartTimer(const int& i)
+    {
+      if (slot[i].used)
+        slot[i].prevMillis = millis();
+
+      return slot[i].used;
+    };
+
+    void enable(const int& i)
+    {
+      slot[i].enabled = true;
+    };
+
+    void disable(const int& i)
+    {
+      slot[i].enabled = false;
+    };
+
+    void toggle(const int& i)
+    {
+      slot[i].enabled = !slot[i].enabled;
+    };
+
+    // as ESP32_ISR_Timer, only the timers which haven't run yet
+    void setAllEnabled(const bool& enabled)
+    {
+      for (int i = 0; i < MAX_NUMBER_TIMERS; i++)
+      {
+        if (slot[i].used && (slot[i].numRuns == 0))
+          slot[i].enabled = enabled;
+      }
+    };
+
+    bool isEnabled(const int& i)
+    {
+      return slot[i].enabled;
+    };
+
+    int getNumTimers()
+    {
+      return numTimers;
+    };
+
+    // tags of the timers due, in slot order
+    void run(std::vector<int>& fired)
+    {
+      unsigned long now = millis();
+      bool          toDelete[MAX_NUMBER_TIMERS] = { false };
+
+      for (int i = 0; i < MAX_NUMBER_TIMERS; i++)
+      {
+        if (!slot[i].used || (now - slot[i].prevMillis < slot[i].delay))
+          continue;
+
+        // missed periods are skipped
+        slot[i].prevMillis += slot[i].delay * ( (now - slot[i].prevMillis) / slot[i].delay);
+
+        if (!slot[i].enabled)
+          continue;
+
+        if (slot[i].maxNumRuns != TIMER_RUN_FOREVER)
+        {
+          if (slot[i].numRuns >= slot[i].maxNumRuns)
+            continue;
+
+          toDelete[i] = (++slot[i].numRuns >= slot[i].maxNumRuns);
+        }
+
+        fired.push_back(slot[i].tag);
+      }
+
+      for (int i = 0; i < MAX_NUMBER_TIMERS; i++)
+      {
+        if (toDelete[i])
+          deleteTimer(i);
+      }
+    };
+
+  private:
+
+    void clearSlot(const int& i)
+    {
+      slot[i].used        = false;
+      slot[i].enabled     = false;
+      slot[i].delay       = 0;
+      slot[i].prevMillis  = millis();
+      slot[i].tag         = -1;
+      slot[i].maxNumRuns  = 0;
+      slot[i].numRuns     = 0;
+    };
+
+    struct
+    {
+      bool          used;
+      bool          enabled;
+      unsigned long delay;
+      unsigned long prevMillis;
+      int           tag;
+      uint32_t      maxNumRuns;
+      uint32_t      numRuns;
+    } slot[MAX_NUMBER_TIMERS];
+
+    int numTimers;
+};
+
+// xorshift32, to get the same sequences on all hosts
+static uint32_t rngState;
+
+static uint32_t rnd(const uint32_t& range)
+{
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+
+  return rngState % range;
+}
+
+static std::vector<int> heapFired;
+
+static void heapCallback(void* tag)
+{
+  heapFired.push_back((int) (intptr_t) tag);
+}
+
+// Returns the number of mismatches, printing the first one
+static int runSeed(const uint32_t& seed)
+{
+  ESP32_ISR_Timer   heapTimers;
+  LinearTimers      linearTimers;
+  std::vector<int>  linearFired;
+  int               ids[64];
+  int               numIds  = 0;
+  int               tag     = 0;
+
+  rngState = seed;
+
+  heapTimers.init();
+
+  for (int step = 0; step < NUM_STEPS; step++)
+  {
+    uint32_t op         = rnd(100);
+    int      id         = (numIds > 0) ? ids[rnd(std::min(numIds, 64))] : 0;
+    bool     sameResult = true;
+
+    if (op < 4)
+    {
+      unsigned long delay   = 1 + rnd(50);
+      uint32_t      numRuns = (rnd(3) == 0) ? 1 + rnd(4) : TIMER_RUN_FOREVER;
+
+      int heapId    = heapTimers.setTimer(delay, heapCallback, (void *) (intptr_t) tag, numRuns);
+      int linearId  = linearTimers.setTimer(delay, tag, numRuns);
+
+      tag++;
+
+      if (heapId != linearId)
+      {
+        printf("seed %u step %d : setTimer() = %d, expected %d\n", seed, step, heapId, linearId);
+
+        return 1;
+      }
+
+      if (heapId >= 0)
+        ids[numIds++ % 64] = heapId;
+    }
+    else if ( (op < 6) && numIds )
+    {
+      sameResult = (heapTimers.deleteTimer(id) == linearTimers.deleteTimer(id));
+    }
+    else if ( (op < 8) && numIds )
+    {
+      unsigned long delay = 1 + rnd(40);
+
+      sameResult = (heapTimers.changeInterval(id, delay) == linearTimers.changeInterval(id, delay));
+    }
+    else if ( (op < 9) && numIds )
+    {
+      sameResult = (heapTimers.restartTimer(id) == linearTimers.restartTimer(id));
+    }
+    else if ( (op < 11) && numIds )
+    {
+      heapTimers.toggle(id);
+      linearTimers.toggle(id);
+    }
+    else if (op < 12)
+    {
+      heapTimers.enableAll();
+      linearTimers.setAllEnabled(true);
+    }
+    else if ( (op < 13) && (rnd(4) == 0) )
+    {
+      heapTimers.disableAll();
+      linearTimers.setAllEnabled(false);
+    }
+    else if ( (op < 14) && numIds )
+    {
+      heapTimers.enable(id);
+      linearTimers.enable(id);
+    }
+    else if ( (op < 15) && numIds )
+    {
+      heapTimers.disable(id);
+      linearTimers.disable(id);
+    }
+
+    if (!sameResult)
+    {
+      printf("seed %u step %d : op %u on timer %d returned differently\n", seed, step, op, id);
+
+      return 1;
+    }
+
+    // mostly 1ms, sometimes late by up to 4 more periods of the fastest timers
+    ESP32Sim::advanceUs(1000 * (1 + ( (rnd(3) == 0) ? rnd(5) : 0) ) );
+
+    heapFired.clear();
+    linearFired.clear();
+
+    heapTimers.run();
+    linearTimers.run(linearFired);
+
+    // the heap calls the due timers in deadline order
+    std::sort(heapFired.begin(), heapFired.end());
+    std::sort(linearFired.begin(), linearFired.end());
+
+    bool same = (heapFired == linearFired) && (heapTimers.getNumTimers() == linearTimers.getNumTimers());
+
+    for (int i = 0; same && (i < MAX_NUMBER_TIMERS); i++)
+      same = (heapTimers.isEnabled(i) == linearTimers.isEnabled(i));
+
+    if (!same)
+    {
+      printf("seed %u step %d, millis() = %lu : %zu callbacks, expected %zu, %d timers, expected %d\n", seed, step,
+             millis(), heapFired.size(), linearFired.size(), (int) heapTimers.getNumTimers(), linearTimers.getNumTimers());
+
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+int main()
+{
+  int failures = 0;
+
+  for (uint32_t seed = 1; seed <= NUM_SEEDS; seed++)
+  {
+    int failed = runSeed(seed);
+
+    printf("seed %u : %s\n", seed, failed ? "FAILED" : "OK");
+
+    failures += failed;
+  }
+
+  return failures ? 1 : 0;
+}